@@ -0,0 +1,559 @@
+/**
+ * @brief benchmarks for every container against std baselines
+ *
+ * build: g++ -O2 -std=c++17 bench/bench.cpp -o bench_main
+ * usage: bench_main [-n keys] [-q ops] [-w window] [-f filter] [--perf]
+ *
+ * every benchmark reports throughput, per-op latency percentiles, the peak heap usage of the
+ * benchmark (setup included) and, with --perf on linux, hardware counters per op.
+ * latencies are measured over batches of batch_ops operations to keep the clock out of the
+ * hot loop, so the percentiles are percentiles of batch averages.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../ordered_containers/bst.h"
+#include "../segtree/segtree.h"
+#include "../minmax_containers/minmax_queue.h"
+#include "../minmax_containers/minmax_stack.h"
+#include "../minmax_containers/aggregate_queue.h"
+#include "../minmax_containers/timed_minmax_queue.h"
+#include "../minmax_containers/multi_window_minmax_queue.h"
+#include "../minmax_containers/quantile_queue.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/***
+ * heap accounting, every allocation carries its size in a header
+ * the replacements are kept out of line, gcc otherwise inlines them into their callers and
+ * warns about the header arithmetic and the malloc/delete pairing
+ */
+namespace mem {
+    size_t live = 0, peak = 0;
+    constexpr size_t header = alignof(std::max_align_t);
+}
+__attribute__((noinline)) void* operator new(size_t sz) {
+    char* p = static_cast<char*>(std::malloc(sz + mem::header));
+    if(!p) throw std::bad_alloc();
+    *reinterpret_cast<size_t*>(p) = sz;
+    mem::live += sz, mem::peak = std::max(mem::peak, mem::live);
+    return p + mem::header;
+}
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    if(!ptr) return;
+    char* p = static_cast<char*>(ptr) - mem::header;
+    mem::live -= *reinterpret_cast<size_t*>(p);
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+// keeps the optimizer from dropping results
+template<typename T>
+inline void keep(T const& val) { asm volatile("" : : "r,m"(val) : "memory"); }
+
+/***
+ * hardware counters
+ */
+struct perf_counters {
+    static constexpr int count = 4;
+    static constexpr char const* names[count] = { "cycles", "instrs", "llc-miss", "br-miss" };
+    int fds[count] = { -1, -1, -1, -1 };
+    bool enabled = false;
+
+    void open() {
+#ifdef __linux__
+        unsigned long long configs[count] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for(int i = 0; i < count; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        enabled = std::any_of(fds, fds + count, [](int fd) { return fd >= 0; });
+        if(!enabled) std::fprintf(stderr, "perf_event_open failed, hardware counters disabled\n");
+#endif
+    }
+    void start() {
+#ifdef __linux__
+        for(int fd : fds) if(fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0), ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    void stop(long long (&out)[count]) {
+        for(int i = 0; i < count; ++i) {
+            out[i] = -1;
+#ifdef __linux__
+            if(fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            long long v;
+            if(read(fds[i], &v, sizeof(v)) == sizeof(v)) out[i] = v;
+#endif
+        }
+    }
+    ~perf_counters() {
+#ifdef __linux__
+        for(int fd : fds) if(fd >= 0) close(fd);
+#endif
+    }
+};
+
+/***
+ * workload generators
+ */
+enum class workload { sequential, uniform, zipfian, sliding };
+constexpr workload all_workloads[] = { workload::sequential, workload::uniform, workload::zipfian, workload::sliding };
+char const* workload_name(workload w) {
+    switch(w) {
+        case workload::sequential: return "seq";
+        case workload::uniform: return "uniform";
+        case workload::zipfian: return "zipf";
+        case workload::sliding: return "sliding";
+    }
+    return "";
+}
+
+// zipf distribution over [0, n), rank r has probability proportional to 1/(r+1)^s
+class zipf_distribution {
+    std::vector<double> _cdf;
+public:
+    zipf_distribution(size_t n, double s) : _cdf(n) {
+        double sum = 0;
+        for(size_t i = 0; i < n; ++i)
+            _cdf[i] = sum += 1.0 / std::pow(double(i + 1), s);
+        for(double& c : _cdf) c /= sum;
+    }
+    template<typename Rng>
+    size_t operator()(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        return std::min<size_t>(std::lower_bound(_cdf.begin(), _cdf.end(), u) - _cdf.begin(), _cdf.size() - 1);
+    }
+};
+
+/** generates count keys in [0, domain)
+ *  sequential: 0,1,2,... wrapping around
+ *  uniform:    uniformly random
+ *  zipfian:    zipf(0.99) ranks, mapped to keys by a random permutation so hot keys are scattered
+ *  sliding:    uniform inside a window of width window that moves from 0 to domain
+ */
+std::vector<int> make_keys(workload w, size_t count, size_t domain, size_t window, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<int> ret(count);
+    switch(w) {
+        case workload::sequential:
+            for(size_t i = 0; i < count; ++i) ret[i] = static_cast<int>(i % domain);
+            break;
+        case workload::uniform: {
+            std::uniform_int_distribution<size_t> dist(0, domain - 1);
+            for(int& k : ret) k = static_cast<int>(dist(rng));
+            break;
+        }
+        case workload::zipfian: {
+            zipf_distribution dist(domain, 0.99);
+            std::vector<int> perm(domain);
+            std::iota(perm.begin(), perm.end(), 0);
+            std::shuffle(perm.begin(), perm.end(), rng);
+            for(int& k : ret) k = perm[dist(rng)];
+            break;
+        }
+        case workload::sliding: {
+            window = std::min(window, domain);
+            std::uniform_int_distribution<size_t> dist(0, window - 1);
+            for(size_t i = 0; i < count; ++i)
+                ret[i] = static_cast<int>(i * (domain - window) / count + dist(rng));
+            break;
+        }
+    }
+    return ret;
+}
+
+/***
+ * runner
+ */
+struct options {
+    size_t n = 1 << 16;      // keys in the ordered containers / array size of the segtrees
+    size_t ops = 1 << 20;    // measured operations per benchmark
+    size_t window = 1 << 10; // window size of the sliding workloads and minmax containers
+    std::string filter;
+    bool perf = false;
+};
+
+class runner {
+    static constexpr size_t batch_ops = 64;
+    options const& _opt;
+    perf_counters _perf;
+public:
+    explicit runner(options const& opt) : _opt(opt) {
+        if(opt.perf) _perf.open();
+        std::printf("%-44s %12s %9s %9s %9s %10s", "benchmark", "ops/s", "p50(ns)", "p99(ns)", "p999(ns)", "peak(KiB)");
+        if(_perf.enabled)
+            for(char const* name : perf_counters::names) std::printf(" %9s", name);
+        std::printf("\n");
+    }
+    options const& opt() const { return _opt; }
+
+    /** runs ops operations, returns false if the benchmark is filtered out
+     *  setup() builds the benchmarked state and returns the operation, a callable taking the op index
+     */
+    template<typename SetupFn>
+    bool run(std::string const& name, size_t ops, SetupFn&& setup) {
+        if(!_opt.filter.empty() && name.find(_opt.filter) == std::string::npos) return false;
+        size_t base = mem::live;
+        mem::peak = mem::live;
+        {
+            auto op = setup();
+            std::vector<double> lat;
+            lat.reserve(ops / batch_ops + 1);
+            long long counters[perf_counters::count];
+
+            using clock = std::chrono::steady_clock;
+            _perf.start();
+            auto begin = clock::now();
+            for(size_t i = 0; i < ops;) {
+                size_t end = std::min(ops, i + batch_ops), cnt = end - i;
+                auto t0 = clock::now();
+                for(; i < end; ++i) op(i);
+                auto t1 = clock::now();
+                lat.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / cnt);
+            }
+            double secs = std::chrono::duration<double>(clock::now() - begin).count();
+            _perf.stop(counters);
+            size_t peak = mem::peak - base;
+
+            std::sort(lat.begin(), lat.end());
+            auto pct = [&](double p) { return lat.empty() ? 0.0 : lat[std::min(lat.size() - 1, size_t(p * lat.size()))]; };
+            std::printf("%-44s %12.0f %9.1f %9.1f %9.1f %10.1f", name.c_str(), ops / secs,
+                        pct(0.5), pct(0.99), pct(0.999), peak / 1024.0);
+            if(_perf.enabled)
+                for(long long c : counters) std::printf(" %9.1f", c < 0 ? -1.0 : double(c) / ops);
+            std::printf("\n");
+        }
+        return true;
+    }
+};
+
+/***
+ * uniform interface over the bst family and std::map/std::set
+ */
+template<typename K, typename V> void put(std::map<K, V>& t, int k) { t.emplace(k, V(k)); }
+template<typename K> void put(std::set<K>& t, int k) { t.insert(k); }
+template<typename Tree> void put(Tree& t, int k) {
+    if constexpr (std::is_same<typename Tree::mapped_t, null_t>::value) t.insert(k);
+    else t.insert(k, typename Tree::mapped_t(k));
+}
+template<typename K, typename V> bool has(std::map<K, V>& t, int k) { return t.count(k); }
+template<typename K> bool has(std::set<K>& t, int k) { return t.count(k); }
+template<typename Tree> bool has(Tree& t, int k) { return t.has(k); }
+
+// inserts, lookups and a sliding insert/erase window on one tree type
+template<typename Tree>
+void bench_tree(runner& r, std::string const& name) {
+    options const& opt = r.opt();
+    for(workload w : all_workloads) {
+        std::string suffix = std::string("/") + workload_name(w);
+        auto keys = std::make_shared<std::vector<int>>(make_keys(w, opt.n, opt.n * 2, opt.window, 1));
+        r.run(name + "/insert" + suffix, opt.n, [&] {
+            return [t = std::make_unique<Tree>(), keys](size_t i) { put(*t, (*keys)[i]); };
+        });
+        auto queries = std::make_shared<std::vector<int>>(make_keys(w, opt.ops, opt.n * 2, opt.window, 2));
+        r.run(name + "/find" + suffix, opt.ops, [&] {
+            auto t = std::make_unique<Tree>();
+            for(int k : make_keys(workload::uniform, opt.n, opt.n * 2, opt.window, 3)) put(*t, k);
+            return [t = std::move(t), queries](size_t i) { keep(has(*t, (*queries)[i])); };
+        });
+    }
+    // keys i - window are erased as keys i are inserted
+    r.run(name + "/insert+erase/window", opt.ops, [&] {
+        size_t window = opt.window;
+        return [t = std::make_unique<Tree>(), window](size_t i) {
+            put(*t, static_cast<int>(i));
+            if(i >= window) t->erase(static_cast<int>(i - window));
+        };
+    });
+}
+
+void bench_trees(runner& r) {
+    bench_tree<std::map<int, int>>(r, "std::map");
+    bench_tree<splaytree<int, int>>(r, "splaytree<int,int>");
+    bench_tree<avltree<int, int>>(r, "avltree<int,int>");
+    bench_tree<rbtree<int, int>>(r, "rbtree<int,int>");
+    bench_tree<sgtree<int, int>>(r, "sgtree<int,int>");
+    bench_tree<std::set<int>>(r, "std::set");
+    bench_tree<splaytree<int>>(r, "splaytree<int>");
+    bench_tree<avltree<int>>(r, "avltree<int>");
+    bench_tree<rbtree<int>>(r, "rbtree<int>");
+    bench_tree<sgtree<int>>(r, "sgtree<int>");
+
+    // point lookups through the hash side index
+    using hashed_meta = size_metadata<int, int>;
+    bench_tree<splaytree<int, int, std::less<int>, hashed_meta, null_tree_stats, hash_index<int>>>(r, "splaytree<int,int,hash_index>");
+    bench_tree<avltree<int, int, std::less<int>, hashed_meta, null_tree_stats, hash_index<int>>>(r, "avltree<int,int,hash_index>");
+    bench_tree<rbtree<int, int, std::less<int>, hashed_meta, null_tree_stats, hash_index<int>>>(r, "rbtree<int,int,hash_index>");
+}
+
+/***
+ * splay policies, reports the restructuring each policy does per lookup
+ */
+template<typename Policy>
+void bench_splay_policy(runner& r, std::string const& name) {
+    using tree = splaytree<int, int, std::less<int>, size_metadata<int, int>, tree_stats, null_index<int>, Policy>;
+    options const& opt = r.opt();
+    for(workload w : { workload::uniform, workload::zipfian, workload::sliding }) {
+        auto t = std::make_shared<tree>();
+        auto queries = std::make_shared<std::vector<int>>(make_keys(w, opt.ops, opt.n * 2, opt.window, 2));
+        bool ran = r.run(name + "/find/" + workload_name(w), opt.ops, [&] {
+            for(int k : make_keys(workload::uniform, opt.n, opt.n * 2, opt.window, 3)) put(*t, k);
+            t->stats().reset();
+            return [t, queries](size_t i) { keep(t->has((*queries)[i])); };
+        });
+        if(ran) {
+            tree_stats const& st = t->stats();
+            std::printf("    rotations/op %.2f, pushups/op %.2f, splays/op %.2f\n",
+                        double(st.rotations) / opt.ops, double(st.pushups) / opt.ops, double(st.splays) / opt.ops);
+        }
+    }
+}
+
+void bench_splay_policies(runner& r) {
+    bench_splay_policy<full_splay>(r, "splaytree<full_splay>");
+    bench_splay_policy<semi_splay>(r, "splaytree<semi_splay>");
+    bench_splay_policy<depth_splay<2, 1>>(r, "splaytree<depth_splay<2,1>>");
+    bench_splay_policy<random_splay<4>>(r, "splaytree<random_splay<4>>");
+}
+
+/***
+ * segment trees against naive arrays
+ */
+struct seg_op { int l, r, val; bool update; };
+std::vector<seg_op> make_seg_ops(workload w, size_t count, size_t n, size_t window) {
+    auto ls = make_keys(w, count, n, window, 4), ls2 = make_keys(workload::uniform, count, n, window, 5);
+    std::mt19937 rng(6);
+    std::vector<seg_op> ret(count);
+    for(size_t i = 0; i < count; ++i) {
+        int a = ls[i], b = ls2[i];
+        ret[i] = { std::min(a, b), std::max(a, b), static_cast<int>(rng() % 100), (rng() & 1) != 0 };
+    }
+    return ret;
+}
+
+void bench_segtrees(runner& r) {
+    options const& opt = r.opt();
+    // naive arrays are O(n) per update, keep the array small enough to finish
+    size_t n = std::min<size_t>(opt.n, 1 << 14), ops = std::min<size_t>(opt.ops, 1 << 16);
+    for(workload w : all_workloads) {
+        std::string suffix = std::string("/") + workload_name(w);
+        auto seg_ops = std::make_shared<std::vector<seg_op>>(make_seg_ops(w, ops, n, opt.window));
+
+        // point update + range sum
+        r.run("sum_segtree/update+query" + suffix, ops, [&] {
+            return [t = std::make_unique<sum_segtree<long long>>(n, 0), seg_ops](size_t i) {
+                seg_op const& o = (*seg_ops)[i];
+                if(o.update) t->update(o.l, o.val);
+                else keep(t->query(o.l, o.r));
+            };
+        });
+        r.run("prefix_array/update+query" + suffix, ops, [&] {
+            return [a = std::vector<long long>(n, 0), pre = std::vector<long long>(n + 1, 0), seg_ops](size_t i) mutable {
+                seg_op const& o = (*seg_ops)[i];
+                if(o.update) {
+                    a[o.l] = o.val;
+                    for(size_t j = o.l; j < a.size(); ++j) pre[j + 1] = pre[j] + a[j];
+                } else {
+                    keep(pre[o.r + 1] - pre[o.l]);
+                }
+            };
+        });
+
+        // range assign + range sum
+        r.run("sum_lazysegtree/assign+query" + suffix, ops, [&] {
+            return [t = std::make_unique<sum_lazysegtree<long long>>(n, 0), seg_ops](size_t i) {
+                seg_op const& o = (*seg_ops)[i];
+                if(o.update) t->update(o.l, o.r, o.val);
+                else keep(t->query(o.l, o.r));
+            };
+        });
+        r.run("prefix_array/assign+query" + suffix, ops, [&] {
+            return [a = std::vector<long long>(n, 0), pre = std::vector<long long>(n + 1, 0), seg_ops](size_t i) mutable {
+                seg_op const& o = (*seg_ops)[i];
+                if(o.update) {
+                    std::fill(a.begin() + o.l, a.begin() + o.r + 1, o.val);
+                    for(size_t j = o.l; j < a.size(); ++j) pre[j + 1] = pre[j] + a[j];
+                } else {
+                    keep(pre[o.r + 1] - pre[o.l]);
+                }
+            };
+        });
+
+        // point update + range min
+        r.run("min_segtree/update+query" + suffix, ops, [&] {
+            return [t = std::make_unique<min_segtree<int>>(n, 0), seg_ops](size_t i) {
+                seg_op const& o = (*seg_ops)[i];
+                if(o.update) t->update(o.l, o.val);
+                else keep(t->query(o.l, o.r));
+            };
+        });
+        r.run("scan_array/update+min" + suffix, ops, [&] {
+            return [a = std::vector<int>(n, 0), seg_ops](size_t i) mutable {
+                seg_op const& o = (*seg_ops)[i];
+                if(o.update) a[o.l] = o.val;
+                else keep(*std::min_element(a.begin() + o.l, a.begin() + o.r + 1));
+            };
+        });
+    }
+}
+
+/***
+ * minmax containers against std::multiset windows
+ */
+void bench_minmax(runner& r) {
+    options const& opt = r.opt();
+    size_t window = opt.window;
+    for(workload w : all_workloads) {
+        std::string suffix = std::string("/") + workload_name(w);
+        auto vals = std::make_shared<std::vector<int>>(make_keys(w, opt.ops, opt.n * 2, window, 7));
+
+        // queue: push with eviction, then read min and max
+        r.run("minmax_queue<fixed>/push+minmax" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<minmax_queue<int, minmax_tag, true>>(window), vals](size_t i) {
+                q->push((*vals)[i]);
+                keep(q->min()), keep(q->max());
+            };
+        });
+        // blocks of 64 values, counted per value
+        r.run("minmax_queue<fixed>/push_range(64)+minmax" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<minmax_queue<int, minmax_tag, true>>(window), vals](size_t i) {
+                if(i % 64 || i + 64 > vals->size()) return;
+                q->push_range(vals->begin() + i, vals->begin() + i + 64);
+                keep(q->min()), keep(q->max());
+            };
+        });
+        r.run("minmax_queue/push+minmax" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<minmax_queue<int, minmax_tag>>(), vals, window](size_t i) {
+                q->push((*vals)[i]);
+                if(q->size() > window) q->pop();
+                keep(q->min()), keep(q->max());
+            };
+        });
+        r.run("std::multiset/push+minmax" + suffix, opt.ops, [&] {
+            return [s = std::make_unique<std::multiset<int>>(), vals, window](size_t i) {
+                s->insert((*vals)[i]);
+                if(i >= window) s->erase(s->find((*vals)[i - window]));
+                keep(*s->begin()), keep(*s->rbegin());
+            };
+        });
+        r.run("aggregate_queue<fixed,min>/push+min" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<aggregate_queue<int, min_compose<int>, true>>(window), vals](size_t i) {
+                q->push((*vals)[i]);
+                keep(q->query());
+            };
+        });
+        r.run("gcd_queue<fixed>/push+gcd" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<gcd_queue<int, true>>(window), vals](size_t i) {
+                q->push((*vals)[i]);
+                keep(q->query());
+            };
+        });
+
+        r.run("quantile_queue<fixed>/push+p50+p99" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<quantile_queue<int, true>>(window), vals](size_t i) {
+                q->push((*vals)[i]);
+                keep(q->quantile(0.5)), keep(q->quantile(0.99));
+            };
+        });
+
+        // four windows of window/64 .. window samples, timestamps being the op index
+        std::vector<long> windows = { long(window / 64) + 1, long(window / 16) + 1, long(window / 4) + 1, long(window) };
+        r.run("multi_window_minmax_queue(4)/push+minmax" + suffix, opt.ops, [&] {
+            return [q = std::make_unique<multi_window_minmax_queue<long, int>>(windows), vals](size_t i) {
+                q->push(long(i), (*vals)[i]);
+                for(size_t w = 0; w < 4; ++w) keep(q->min(w)), keep(q->max(w));
+            };
+        });
+        r.run("timed_minmax_queue x4/push+minmax" + suffix, opt.ops, [&] {
+            auto qs = std::make_unique<std::vector<timed_minmax_queue<long, int>>>();
+            for(long w : windows) qs->emplace_back(w);
+            return [qs = std::move(qs), vals](size_t i) {
+                for(auto& q : *qs) q.push(long(i), (*vals)[i]), keep(q.min()), keep(q.max());
+            };
+        });
+
+        // stack: random walk of the size around window, reading min and max after each op
+        auto pushes = std::make_shared<std::vector<bool>>(opt.ops);
+        std::mt19937 rng(8);
+        for(size_t i = 0; i < opt.ops; ++i) (*pushes)[i] = (rng() & 1) != 0;
+        r.run("minmax_stack/push|pop+minmax" + suffix, opt.ops, [&] {
+            auto st = std::make_unique<minmax_stack<int, minmax_tag>>();
+            for(size_t i = 0; i < window; ++i) st->push((*vals)[i]);
+            return [st = std::move(st), vals, pushes](size_t i) {
+                if((*pushes)[i] || st->size() <= 1) st->push((*vals)[i]);
+                else st->pop();
+                keep(st->min()), keep(st->max());
+            };
+        });
+        r.run("std::multiset/push|pop+minmax" + suffix, opt.ops, [&] {
+            auto s = std::make_unique<std::multiset<int>>();
+            auto order = std::make_unique<std::vector<std::multiset<int>::iterator>>();
+            for(size_t i = 0; i < window; ++i) order->push_back(s->insert((*vals)[i]));
+            return [s = std::move(s), order = std::move(order), vals, pushes](size_t i) {
+                if((*pushes)[i] || s->size() <= 1) order->push_back(s->insert((*vals)[i]));
+                else s->erase(order->back()), order->pop_back();
+                keep(*s->begin()), keep(*s->rbegin());
+            };
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    options opt;
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> char const* {
+            if(i + 1 >= argc) { std::fprintf(stderr, "missing value for %s\n", arg.c_str()); std::exit(1); }
+            return argv[++i];
+        };
+        if(arg == "-n") opt.n = std::strtoull(next(), nullptr, 10);
+        else if(arg == "-q") opt.ops = std::strtoull(next(), nullptr, 10);
+        else if(arg == "-w") opt.window = std::strtoull(next(), nullptr, 10);
+        else if(arg == "-f") opt.filter = next();
+        else if(arg == "--perf") opt.perf = true;
+        else {
+            std::fprintf(stderr, "usage: %s [-n keys] [-q ops] [-w window] [-f filter] [--perf]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(!opt.n || !opt.ops || !opt.window) {
+        std::fprintf(stderr, "-n, -q and -w must be positive\n");
+        return 1;
+    }
+    runner r(opt);
+    bench_trees(r);
+    bench_splay_policies(r);
+    bench_segtrees(r);
+    bench_minmax(r);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "static_deque.h"
+#include <type_traits>
+#include <functional>
+#include <numeric>
+#include <deque>
+
+/**
+ * @brief FIFO queue with amortized O(1) aggregation over an associative operation
+ *
+ * Two-stack queue: pushes fold into a running back aggregate, pops are served from a stack of
+ * suffix aggregates that is rebuilt from the elements whenever it runs empty.
+ * CombineFn needs associativity only, no inverse and no identity.
+ *
+ * @tparam DataType   type of data
+ * @tparam CombineFn  a binary function that takes two DataType and returns a combined DataType,
+ *                    called with the older element first
+ * @tparam FixedSize  sets a maximum size for the queue, making it more efficient and enabling eviction
+ */
+template <typename DataType, typename CombineFn = std::plus<DataType>, bool FixedSize = false>
+class aggregate_queue {
+    struct dummy { dummy() { } dummy(int) { } };
+
+    using deque_type = std::conditional_t<FixedSize, static_deque<DataType>, std::deque<DataType>>;
+public:
+    template<bool Enable = FixedSize, typename Require = std::enable_if_t<Enable>>
+    explicit aggregate_queue(size_t n, CombineFn combinefn = CombineFn())
+        : _size(n), _elements(n), _front(n), _combineFn(combinefn) { }
+    template<bool Enable = !FixedSize, typename Require = std::enable_if_t<Enable>>
+    explicit aggregate_queue(CombineFn combinefn = CombineFn()) : _combineFn(combinefn) { }
+
+    void push(DataType const& val) {
+        // eviction if fixed size
+        if constexpr (FixedSize) {
+            if(!_size) {
+                return;
+            } else if(_elements.size() == _size) {
+                pop();
+            }
+        }
+
+        _back = _elements.size() == _front.size() ? val : _combineFn(_back, val);
+        _elements.push_back(val);
+    }
+    void pop() {
+        if(_front.empty())
+            _flip();
+        _front.pop_back();
+        _elements.pop_front();
+    }
+    /**
+     * @brief aggregate of all elements in the queue, oldest first; the queue must not be empty
+     */
+    DataType query() const {
+        if(_front.empty())
+            return _back;
+        if(_elements.size() == _front.size())
+            return _front.back();
+        return _combineFn(_front.back(), _back);
+    }
+    size_t size() const {
+        return _elements.size();
+    }
+    DataType const& front() const {
+        return _elements.front();
+    }
+    DataType const& back() const {
+        return _elements.back();
+    }
+    DataType const& operator[](int index) const {
+        return _elements[index];
+    }
+private:
+    // moves every element onto the front stack, top being the aggregate of the whole queue
+    void _flip() {
+        for(size_t i = _elements.size(); i--; ) {
+            if(_front.empty())
+                _front.push_back(_elements[i]);
+            else
+                _front.push_back(_combineFn(_elements[i], _front.back()));
+        }
+    }
+
+    std::conditional_t<FixedSize, size_t, dummy> _size;
+    deque_type _elements;
+    // suffix aggregates of the oldest _front.size() elements, the oldest element on top
+    deque_type _front;
+    // aggregate of the remaining, newer elements
+    DataType _back{};
+    mutable CombineFn _combineFn;
+};
+
+template<typename DataType>
+struct gcd_compose {
+    DataType operator()(DataType const& data1, DataType const& data2) const {
+        return std::gcd(data1, data2);
+    }
+};
+template<typename DataType, bool FixedSize = false>
+using sum_queue = aggregate_queue<DataType, std::plus<DataType>, FixedSize>;
+template<typename DataType, bool FixedSize = false>
+using gcd_queue = aggregate_queue<DataType, gcd_compose<DataType>, FixedSize>;
+template<typename DataType, bool FixedSize = false>
+using or_queue = aggregate_queue<DataType, std::bit_or<DataType>, FixedSize>;
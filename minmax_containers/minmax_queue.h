@@ -2,11 +2,13 @@
 #include "static_deque.h"
 #include "tags.h"
 #include <type_traits>
+#include <iterator>
+#include <deque>
 
 /**
  * @brief FIFO queue with O(1) min and max operations
  * 
- * @tparam DataType   type of data, must implement operator<,==,>
+ * @tparam DataType   type of data, must implement operator<,>
  * @tparam Tag        min_tag: min() only; max_tag: max() only; minmax_tag: both are available
  * @tparam FixedSize  sets a maximum size for the queue, making it more efficient and enabling eviction
  */
@@ -18,7 +20,11 @@ class minmax_queue {
     using use_min_queue = std::disjunction<std::is_same<T, min_tag>, std::is_same<T, minmax_tag>>;
     template<typename T>
     using use_max_queue = std::disjunction<std::is_same<T, max_tag>, std::is_same<T, minmax_tag>>;
+    template<typename It>
+    using is_forward_iterator = std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>;
     using deque_type = std::conditional_t<FixedSize, static_deque<DataType>, std::deque<DataType>>;
+    // the monotone queues hold sequence numbers, element seq lives at _elements[seq - _popped]
+    using mono_deque_type = std::conditional_t<FixedSize, static_deque<size_t>, std::deque<size_t>>;
 public:
     template<bool Enable = FixedSize, typename Require = std::enable_if_t<Enable>>
     explicit minmax_queue(size_t n) : _size(n), _elements(n), _minq(n), _maxq(n) { }
@@ -34,40 +40,67 @@ public:
                 pop();
             }
         }
-
-		// the _maxq is monotonically non-increasing
+        _push(val);
+	}
+    /**
+     * @brief pushes [first, last) in order
+     * with FixedSize and a forward range, the leading values that would be evicted by the same
+     * batch are skipped and the old elements are evicted in one go
+     */
+    template<typename It>
+    void push_range(It first, It last) {
+        if constexpr (FixedSize && is_forward_iterator<It>::value) {
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            if(n >= _size) {
+                pop_n(size());
+                std::advance(first, n - _size);
+            } else if(size() + n > _size) {
+                pop_n(size() + n - _size);
+            }
+            for(; first != last; ++first)
+                _push(*first);
+        } else {
+            for(; first != last; ++first)
+                push(*first);
+        }
+    }
+    void pop() {
         if constexpr (use_max_queue<Tag>::value) {
-            while(!_maxq.empty() && _maxq.back() < val)
-                _maxq.pop_back();
-            _maxq.push_back(val);
+            if(_maxq.front() == _popped)
+                _maxq.pop_front();
         }
         if constexpr (use_min_queue<Tag>::value) {
-            // the min_q is monotonically non-decreasing
-            while(!_minq.empty() && _minq.back() > val)
-                _minq.pop_back();
-            _minq.push_back(val);
+            if(_minq.front() == _popped)
+                _minq.pop_front();
         }
-
-        _elements.push_back(val);
-	}
-    void pop() {
+        _elements.pop_front();
+        ++_popped;
+    }
+    /**
+     * @brief pops the k oldest elements, k must not exceed size()
+     */
+    void pop_n(size_t k) {
+        _popped += k;
         if constexpr (use_max_queue<Tag>::value) {
-            if(!_maxq.empty() && _maxq.front() == _elements.front())
+            while(!_maxq.empty() && _maxq.front() < _popped)
                 _maxq.pop_front();
         }
         if constexpr (use_min_queue<Tag>::value) {
-            if(!_minq.empty() && _minq.front() == _elements.front())
+            while(!_minq.empty() && _minq.front() < _popped)
                 _minq.pop_front();
         }
-        _elements.pop_front();
+        if constexpr (FixedSize)
+            _elements.pop_front(k);
+        else
+            _elements.erase(_elements.begin(), _elements.begin() + k);
     }
     template<typename T = Tag, typename Require = std::enable_if_t<use_max_queue<T>::value>>
     DataType const& max() const {
-		return _maxq.front();
+		return _at(_maxq.front());
 	}
     template<typename T = Tag, typename Require = std::enable_if_t<use_min_queue<T>::value>>
 	DataType const& min() const {
-		return _minq.front();
+		return _at(_minq.front());
 	}
     size_t size() const {
         return _elements.size();
@@ -82,8 +115,30 @@ public:
         return _elements[index];
     }
 private:
+    DataType const& _at(size_t seq) const {
+        return _elements[seq - _popped];
+    }
+    void _push(DataType const& val) {
+        size_t seq = _popped + _elements.size();
+        _elements.push_back(val);
+
+		// the _maxq is monotonically non-increasing
+        if constexpr (use_max_queue<Tag>::value) {
+            while(!_maxq.empty() && _at(_maxq.back()) < val)
+                _maxq.pop_back();
+            _maxq.push_back(seq);
+        }
+        if constexpr (use_min_queue<Tag>::value) {
+            // the min_q is monotonically non-decreasing
+            while(!_minq.empty() && _at(_minq.back()) > val)
+                _minq.pop_back();
+            _minq.push_back(seq);
+        }
+    }
+
     std::conditional_t<FixedSize, size_t, dummy> _size;
+    size_t _popped = 0;
     deque_type _elements;
-    std::conditional_t<use_min_queue<Tag>::value, deque_type, dummy> _minq;
-    std::conditional_t<use_max_queue<Tag>::value, deque_type, dummy> _maxq;
+    std::conditional_t<use_min_queue<Tag>::value, mono_deque_type, dummy> _minq;
+    std::conditional_t<use_max_queue<Tag>::value, mono_deque_type, dummy> _maxq;
 };
\ No newline at end of file
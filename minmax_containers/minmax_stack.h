@@ -2,6 +2,7 @@
 #include "static_deque.h"
 #include "tags.h"
 #include <type_traits>
+#include <vector>
 
 /**
  * @brief FILO satck with O(1) min and max operations
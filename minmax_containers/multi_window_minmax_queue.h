@@ -0,0 +1,139 @@
+#pragma once
+#include "tags.h"
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <deque>
+
+/**
+ * @brief min and max over several time windows (now - window_i, now] of a single sample stream
+ * 
+ * samples are stored once, for the longest window. there is one monotone queue per tag over that
+ * buffer, and every window keeps a cursor to its first entry, so a push does one monotone update
+ * plus one O(1) cursor fix per window. count-based windows are the special case of timestamps
+ * being the sample sequence numbers.
+ * 
+ * @tparam Timestamp  type of the timestamps, e.g. a std::chrono::time_point or an integer;
+ *                    timestamps must be pushed in non-decreasing order
+ * @tparam DataType   type of data, must implement operator<,>
+ * @tparam Tag        min_tag: min() only; max_tag: max() only; minmax_tag: both are available
+ */
+template <typename Timestamp, typename DataType, typename Tag = minmax_tag>
+class multi_window_minmax_queue {
+    struct dummy { dummy() { } dummy(int) { } };
+
+    template<typename T>
+    using use_min_queue = std::disjunction<std::is_same<T, min_tag>, std::is_same<T, minmax_tag>>;
+    template<typename T>
+    using use_max_queue = std::disjunction<std::is_same<T, max_tag>, std::is_same<T, minmax_tag>>;
+
+    // monotone queue of sample sequence numbers, Cmp(back, val) pops the back
+    // positions are absolute: entry p lives at seqs[p - popped]
+    template<typename Cmp>
+    struct mono_queue {
+        std::deque<size_t> seqs;
+        size_t popped = 0;
+        std::vector<size_t> cursors;
+
+        explicit mono_queue(size_t n = 0) : cursors(n) { }
+        size_t end() const { return popped + seqs.size(); }
+        size_t seq_at(size_t pos) const { return seqs[pos - popped]; }
+    };
+public:
+    using duration_t = decltype(std::declval<Timestamp>() - std::declval<Timestamp>());
+
+    explicit multi_window_minmax_queue(std::vector<duration_t> windows)
+        : _windows(std::move(windows)), _starts(_windows.size()), _minq(_windows.size()), _maxq(_windows.size()) { }
+
+    /**
+     * @brief advances the clock to ts and pushes val into every window
+     */
+    void push(Timestamp const& ts, DataType const& val) {
+        advance_to(ts);
+        size_t seq = _end();
+        _elements.push_back(val);
+        _stamps.push_back(ts);
+        if constexpr (use_min_queue<Tag>::value)
+            _push(_minq, seq, val);
+        if constexpr (use_max_queue<Tag>::value)
+            _push(_maxq, seq, val);
+    }
+    /**
+     * @brief expires, in every window i, the samples pushed at or before now - window(i)
+     */
+    void advance_to(Timestamp const& now) {
+        size_t end = _end();
+        size_t lo = end;
+        for(size_t i = 0; i < _windows.size(); ++i) {
+            while(_starts[i] < end && !(now - _stamps[_starts[i] - _popped] < _windows[i]))
+                ++_starts[i];
+            lo = std::min(lo, _starts[i]);
+        }
+        if constexpr (use_min_queue<Tag>::value)
+            _advance(_minq, lo);
+        if constexpr (use_max_queue<Tag>::value)
+            _advance(_maxq, lo);
+        for(; _popped < lo; ++_popped) {
+            _elements.pop_front();
+            _stamps.pop_front();
+        }
+    }
+    template<typename T = Tag, typename Require = std::enable_if_t<use_max_queue<T>::value>>
+    DataType const& max(size_t window_id) const {
+        return _at(_maxq.seq_at(_maxq.cursors[window_id]));
+    }
+    template<typename T = Tag, typename Require = std::enable_if_t<use_min_queue<T>::value>>
+    DataType const& min(size_t window_id) const {
+        return _at(_minq.seq_at(_minq.cursors[window_id]));
+    }
+    /**
+     * @brief number of samples in window window_id
+     */
+    size_t size(size_t window_id) const {
+        return _end() - _starts[window_id];
+    }
+    size_t windows() const {
+        return _windows.size();
+    }
+    duration_t window(size_t window_id) const {
+        return _windows[window_id];
+    }
+private:
+    size_t _end() const {
+        return _popped + _elements.size();
+    }
+    DataType const& _at(size_t seq) const {
+        return _elements[seq - _popped];
+    }
+    template<typename Cmp>
+    void _push(mono_queue<Cmp>& q, size_t seq, DataType const& val) {
+        while(!q.seqs.empty() && Cmp()(_at(q.seqs.back()), val))
+            q.seqs.pop_back();
+        q.seqs.push_back(seq);
+        // cursors past the popped entries now start at the new sample
+        size_t pos = q.end() - 1;
+        for(size_t& c : q.cursors)
+            c = std::min(c, pos);
+    }
+    template<typename Cmp>
+    void _advance(mono_queue<Cmp>& q, size_t lo) {
+        for(size_t i = 0; i < _windows.size(); ++i) {
+            size_t& c = q.cursors[i];
+            while(c < q.end() && q.seq_at(c) < _starts[i])
+                ++c;
+        }
+        for(; !q.seqs.empty() && q.seqs.front() < lo; ++q.popped)
+            q.seqs.pop_front();
+    }
+
+    std::vector<duration_t> _windows;
+    // first sample sequence number of every window
+    std::vector<size_t> _starts;
+    size_t _popped = 0;
+    std::deque<DataType> _elements;
+    std::deque<Timestamp> _stamps;
+    std::conditional_t<use_min_queue<Tag>::value, mono_queue<std::greater<DataType>>, dummy> _minq;
+    std::conditional_t<use_max_queue<Tag>::value, mono_queue<std::less<DataType>>, dummy> _maxq;
+};
\ No newline at end of file
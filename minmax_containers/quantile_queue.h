@@ -0,0 +1,86 @@
+#pragma once
+#include "../ordered_containers/bst.h"
+#include "static_deque.h"
+#include <type_traits>
+#include <utility>
+#include <cmath>
+#include <deque>
+
+/**
+ * @brief FIFO queue with O(log n) push, pop, k-th smallest and quantile queries
+ * 
+ * the window is mirrored in an avltree keyed by (value, sequence number), so equal values stay
+ * distinct, and order statistics come from update_policy::at(k)
+ * 
+ * @tparam DataType   type of data, must implement operator<
+ * @tparam FixedSize  sets a maximum size for the queue, enabling eviction
+ */
+template <typename DataType, bool FixedSize = false>
+class quantile_queue {
+    struct dummy { dummy() { } dummy(int) { } };
+
+    using deque_type = std::conditional_t<FixedSize, static_deque<DataType>, std::deque<DataType>>;
+    using tree_type = avltree<std::pair<DataType, size_t>>;
+public:
+    template<bool Enable = FixedSize, typename Require = std::enable_if_t<Enable>>
+    explicit quantile_queue(size_t n) : _size(n), _elements(n) { }
+    template<bool Enable = !FixedSize, typename Require = std::enable_if_t<Enable>>
+    quantile_queue() { }
+
+    void push(DataType const& val) {
+        // eviction if fixed size
+        if constexpr (FixedSize) {
+            if(!_size) {
+                return;
+            } else if(_elements.size() == _size) {
+                pop();
+            }
+        }
+        _tree.insert(std::make_pair(val, _popped + _elements.size()));
+        _elements.push_back(val);
+    }
+    void pop() {
+        _tree.erase(std::make_pair(_elements.front(), _popped));
+        _elements.pop_front();
+        ++_popped;
+    }
+    /**
+     * @brief k-th smallest value in the queue, 0-indexed
+     */
+    DataType const& kth(size_t k) const {
+        return _tree.get(_tree.at(k)).key.first;
+    }
+    /**
+     * @brief nearest-rank quantile: the smallest value with at least q * size() values <= it,
+     * q in [0, 1]; the queue must not be empty
+     */
+    DataType const& quantile(double q) const {
+        size_t n = _elements.size();
+        double rank = std::ceil(q * static_cast<double>(n));
+        size_t k = rank < 1 ? 0 : static_cast<size_t>(rank) - 1;
+        return kth(k < n ? k : n - 1);
+    }
+    DataType const& min() const {
+        return kth(0);
+    }
+    DataType const& max() const {
+        return kth(_elements.size() - 1);
+    }
+    size_t size() const {
+        return _elements.size();
+    }
+    DataType const& front() const {
+        return _elements.front();
+    }
+    DataType const& back() const {
+        return _elements.back();
+    }
+    DataType const& operator[](size_t index) const {
+        return _elements[index];
+    }
+private:
+    std::conditional_t<FixedSize, size_t, dummy> _size;
+    size_t _popped = 0;
+    deque_type _elements;
+    tree_type _tree;
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include "minmax_queue.h"
+#include "spsc_ring.h"
+#include "tags.h"
+#include <type_traits>
+
+/**
+ * @brief sliding window min/max fed from another thread
+ * 
+ * the producer thread calls push(), which only writes into a lock-free spsc_ring.
+ * the consumer thread calls poll() to drain the ring into its own fixed size minmax_queue, so all
+ * monotone queue work happens on the consumer side, and then reads min()/max() there.
+ * 
+ * @tparam DataType   type of data, must implement operator<,>
+ * @tparam Tag        min_tag: min() only; max_tag: max() only; minmax_tag: both are available
+ */
+template <typename DataType, typename Tag = min_tag>
+class spsc_minmax_queue {
+    template<typename T>
+    using use_min_queue = std::disjunction<std::is_same<T, min_tag>, std::is_same<T, minmax_tag>>;
+    template<typename T>
+    using use_max_queue = std::disjunction<std::is_same<T, max_tag>, std::is_same<T, minmax_tag>>;
+public:
+    /**
+     * @param n         window size in samples
+     * @param ring_size samples the producer may run ahead of the consumer
+     */
+    explicit spsc_minmax_queue(size_t n, size_t ring_size = 1024) : _ring(ring_size), _window(n) { }
+
+    /**
+     * @brief producer side, returns false if the consumer fell ring_size samples behind
+     */
+    bool push(DataType const& val) {
+        return _ring.try_push(val);
+    }
+    /**
+     * @brief consumer side, moves every published sample into the window
+     * @return number of samples moved
+     */
+    size_t poll() {
+        return _ring.consume([this](DataType const* first, DataType const* last) {
+            _window.push_range(first, last);
+        });
+    }
+    template<typename T = Tag, typename Require = std::enable_if_t<use_max_queue<T>::value>>
+    DataType const& max() const {
+        return _window.max();
+    }
+    template<typename T = Tag, typename Require = std::enable_if_t<use_min_queue<T>::value>>
+    DataType const& min() const {
+        return _window.min();
+    }
+    /**
+     * @brief consumer side, samples in the window
+     */
+    size_t size() const {
+        return _window.size();
+    }
+private:
+    spsc_ring<DataType> _ring;
+    minmax_queue<DataType, Tag, true> _window;
+};
\ No newline at end of file
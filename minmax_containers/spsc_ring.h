@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+/**
+ * @brief lock-free single-producer/single-consumer ring buffer
+ * 
+ * push side and pop side may run on two different threads, each side must stay on one thread.
+ * head and tail live on their own cache lines, next to a cached copy of the other side's counter,
+ * so the two threads only touch each other's line when the ring looks full or empty.
+ * the buffer is allocated once in the constructor, push and pop never allocate.
+ * 
+ * @tparam DataType  type of data, must be default constructible and copy assignable
+ */
+template<typename DataType>
+class spsc_ring {
+    static constexpr size_t cache_line = 64;
+
+    static size_t _round_up(size_t n) {
+        size_t cap = 1;
+        while(cap < n)
+            cap <<= 1;
+        return cap;
+    }
+public:
+    /**
+     * @brief holds at least n elements, the capacity is rounded up to a power of two
+     */
+    explicit spsc_ring(size_t n) : _mask(_round_up(n) - 1), _arr(new DataType[_mask + 1]) { }
+    spsc_ring(spsc_ring const&) = delete;
+    spsc_ring& operator=(spsc_ring const&) = delete;
+
+    /**
+     * @brief producer side, returns false if the ring is full
+     */
+    bool try_push(DataType const& val) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _head_cache > _mask) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            if(tail - _head_cache > _mask)
+                return false;
+        }
+        _arr[tail & _mask] = val;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    /**
+     * @brief consumer side, returns false if the ring is empty
+     */
+    bool try_pop(DataType& val) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tail_cache) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if(head == _tail_cache)
+                return false;
+        }
+        val = _arr[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    /**
+     * @brief consumer side, hands everything published so far to f as at most two contiguous
+     * ranges f(first, last) in FIFO order, then releases the slots at once
+     * @return number of elements consumed
+     */
+    template<typename SpanFn>
+    size_t consume(SpanFn f) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        _tail_cache = _tail.load(std::memory_order_acquire);
+        size_t n = _tail_cache - head;
+        if(!n)
+            return 0;
+        size_t first = head & _mask;
+        size_t len = std::min(n, _mask + 1 - first);
+        f(static_cast<DataType const*>(&_arr[first]), static_cast<DataType const*>(&_arr[first] + len));
+        if(len < n)
+            f(static_cast<DataType const*>(&_arr[0]), static_cast<DataType const*>(&_arr[0] + (n - len)));
+        _head.store(head + n, std::memory_order_release);
+        return n;
+    }
+    size_t capacity() const {
+        return _mask + 1;
+    }
+    /**
+     * @brief exact only when called with both sides quiescent
+     */
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+private:
+    size_t const _mask;
+    std::unique_ptr<DataType[]> const _arr;
+    // consumer line
+    alignas(cache_line) std::atomic<size_t> _head{0};
+    size_t _tail_cache = 0;
+    // producer line
+    alignas(cache_line) std::atomic<size_t> _tail{0};
+    size_t _head_cache = 0;
+};
\ No newline at end of file
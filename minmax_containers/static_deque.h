@@ -1,71 +1,184 @@
 #pragma once
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
 
+/**
+ * @brief fixed capacity ring storage, the capacity is rounded up to a power of two so that
+ * indexing is a mask; any size_t index is valid and wraps around
+ */
 template<typename DataType>
 struct circular_array
 {
     DataType* _arr;
-    size_t _size;
-    explicit circular_array(size_t size) : _size(size) {
-        _arr = new DataType[size];
+    size_t _mask;
+
+    static size_t _round_up(size_t n) {
+        size_t cap = 1;
+        while(cap < n)
+            cap <<= 1;
+        return cap;
+    }
+
+    explicit circular_array(size_t size) : _mask(_round_up(size) - 1) {
+        _arr = new DataType[_mask + 1];
     }
-    circular_array(circular_array const& other) noexcept
-        : _arr(new DataType[other._size]), _size(other._size) {
-        memcpy(_arr, other._arr, _size * sizeof(DataType));
+    circular_array(circular_array const& other)
+        : _arr(new DataType[other._mask + 1]), _mask(other._mask) {
+        std::copy(other._arr, other._arr + _mask + 1, _arr);
     }
     circular_array(circular_array&& other) noexcept
-        : _arr(other._arr), _size(other._size) {
+        : _arr(other._arr), _mask(other._mask) {
         other._arr = nullptr;
-        other._size = 0;
+        other._mask = 0;
     }
-    circular_array& operator=(circular_array const& other) noexcept {
+    circular_array& operator=(circular_array const& other) {
         if(this == &other)
             return *this;
-        _arr = new DataType[other._size];
-        _size = other._size;
-        memcpy(_arr, other._arr, _size * sizeof(DataType));
+        // reuse the storage when the capacities match
+        if(_mask != other._mask || !_arr) {
+            DataType* arr = new DataType[other._mask + 1];
+            delete[] _arr;
+            _arr = arr;
+            _mask = other._mask;
+        }
+        std::copy(other._arr, other._arr + _mask + 1, _arr);
+        return *this;
     }
     circular_array& operator=(circular_array&& other) noexcept {
         if(this == &other)
             return *this;
+        delete[] _arr;
         _arr = other._arr;
-        _size = other._size;
+        _mask = other._mask;
         other._arr = nullptr;
-        other._size = 0;
+        other._mask = 0;
+        return *this;
     }
 
     ~circular_array() {
         delete[] _arr;
     }
-    DataType const& operator[](int index) const {
-        if(index < 0)
-            return _arr[(index % _size + _size) % _size];
-        else if(static_cast<size_t>(index) >= _size)
-            return _arr[index % _size];
-        else
-            return _arr[index];
+    size_t capacity() const {
+        return _arr ? _mask + 1 : 0;
     }
-    DataType& operator[](int index) {
-        return const_cast<DataType&>((*const_cast<circular_array const*>(this))[index]);
+    DataType const& operator[](size_t index) const {
+        return _arr[index & _mask];
+    }
+    DataType& operator[](size_t index) {
+        return _arr[index & _mask];
+    }
+    /**
+     * @brief length of the contiguous run starting at index, at most n
+     */
+    size_t run(size_t index, size_t n) const {
+        return std::min(n, _mask + 1 - (index & _mask));
     }
 };
 
+/**
+ * @brief deque over a circular_array, head and tail are size_t counters that may wrap around,
+ * only their difference is meaningful
+ */
 template<typename DataType>
 struct static_deque
 {
 	circular_array<DataType> arr;
-	int head=0, tail=0;
-	
+	size_t head=0, tail=0;
+
+    template<bool Const>
+    class basic_iterator {
+        friend struct static_deque;
+        using deque_ptr = std::conditional_t<Const, static_deque const*, static_deque*>;
+        deque_ptr _dq = nullptr;
+        size_t _pos = 0;
+        basic_iterator(deque_ptr dq, size_t pos) : _dq(dq), _pos(pos) { }
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = DataType;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, DataType const*, DataType*>;
+        using reference = std::conditional_t<Const, DataType const&, DataType&>;
+
+        basic_iterator() = default;
+        template<bool C = Const, typename Require = std::enable_if_t<C>>
+        basic_iterator(basic_iterator<false> const& it) : _dq(it._dq), _pos(it._pos) { }
+
+        reference operator*() const { return _dq->arr[_pos]; }
+        pointer operator->() const { return &_dq->arr[_pos]; }
+        reference operator[](difference_type n) const { return _dq->arr[_pos + n]; }
+        basic_iterator& operator++() { ++_pos; return *this; }
+        basic_iterator operator++(int) { basic_iterator it = *this; ++_pos; return it; }
+        basic_iterator& operator--() { --_pos; return *this; }
+        basic_iterator operator--(int) { basic_iterator it = *this; --_pos; return it; }
+        basic_iterator& operator+=(difference_type n) { _pos += n; return *this; }
+        basic_iterator& operator-=(difference_type n) { _pos -= n; return *this; }
+        basic_iterator operator+(difference_type n) const { return basic_iterator(_dq, _pos + n); }
+        friend basic_iterator operator+(difference_type n, basic_iterator const& it) { return it + n; }
+        basic_iterator operator-(difference_type n) const { return basic_iterator(_dq, _pos - n); }
+        difference_type operator-(basic_iterator const& other) const { return static_cast<difference_type>(_pos - other._pos); }
+        bool operator==(basic_iterator const& other) const { return _pos == other._pos; }
+        bool operator!=(basic_iterator const& other) const { return _pos != other._pos; }
+        // positions are compared relative to head so that wrapped counters still order correctly
+        bool operator<(basic_iterator const& other) const { return _pos - _dq->head < other._pos - _dq->head; }
+        bool operator>(basic_iterator const& other) const { return other < *this; }
+        bool operator<=(basic_iterator const& other) const { return !(other < *this); }
+        bool operator>=(basic_iterator const& other) const { return !(*this < other); }
+
+        friend class basic_iterator<!Const>;
+    };
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
 	explicit static_deque(size_t size) : arr(size) { }
 
-	size_t size() const { return static_cast<size_t>(tail-head); }
+	size_t size() const { return tail-head; }
 	bool empty() const { return head==tail; }
+    size_t capacity() const { return arr.capacity(); }
 	DataType& back() { return arr[tail-1]; }
     DataType const& back() const { return arr[tail-1]; }
     DataType& front() { return arr[head]; }
     DataType const& front() const { return arr[head]; }
-    DataType& operator[](int index) { return arr[head+index]; }
-    DataType const& operator[](int index) const { return arr[head+index]; }
+    DataType& operator[](size_t index) { return arr[head+index]; }
+    DataType const& operator[](size_t index) const { return arr[head+index]; }
 	void pop_front() { ++head; }
 	void pop_back() { --tail; }
 	void push_back(DataType const& val) { arr[tail++] = val; }
+	void push_front(DataType const& val) { arr[--head] = val; }
+    void clear() { head = tail; }
+
+    /**
+     * @brief bulk versions, each one is at most two contiguous copies
+     * the pushes need the room to be there
+     */
+    void push_back(DataType const* first, DataType const* last) {
+        size_t n = static_cast<size_t>(last - first);
+        size_t len = arr.run(tail, n);
+        std::copy(first, first + len, &arr[tail]);
+        std::copy(first + len, last, &arr[tail + len]);
+        tail += n;
+    }
+    void push_front(DataType const* first, DataType const* last) {
+        size_t n = static_cast<size_t>(last - first);
+        head -= n;
+        size_t len = arr.run(head, n);
+        std::copy(first, first + len, &arr[head]);
+        std::copy(first + len, last, &arr[head + len]);
+    }
+    // copies the n front elements to out, then pops them
+    void pop_front(DataType* out, size_t n) {
+        size_t len = arr.run(head, n);
+        std::copy(&arr[head], &arr[head] + len, out);
+        std::copy(&arr[head + len], &arr[head + len] + (n - len), out + len);
+        head += n;
+    }
+    void pop_front(size_t n) { head += n; }
+    void pop_back(size_t n) { tail -= n; }
+
+    iterator begin() { return iterator(this, head); }
+    iterator end() { return iterator(this, tail); }
+    const_iterator begin() const { return const_iterator(this, head); }
+    const_iterator end() const { return const_iterator(this, tail); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+#include "minmax_queue.h"
+#include "static_deque.h"
+#include "tags.h"
+#include <type_traits>
+#include <utility>
+#include <deque>
+
+/**
+ * @brief time-windowed FIFO queue with O(1) min and max over the values pushed in (now - window, now]
+ * 
+ * expiry is amortized O(1): every value is evicted exactly once, either by advance_to() or by a push
+ * 
+ * @tparam Timestamp  type of the timestamps, e.g. a std::chrono::time_point or an integer;
+ *                    timestamps must be pushed in non-decreasing order
+ * @tparam DataType   type of data, must implement operator<,>
+ * @tparam Tag        min_tag: min() only; max_tag: max() only; minmax_tag: both are available
+ * @tparam FixedSize  also caps the number of values held, evicting the oldest ones first to bound memory on bursts
+ */
+template <typename Timestamp, typename DataType, typename Tag = minmax_tag, bool FixedSize = false>
+class timed_minmax_queue {
+    struct dummy { dummy() { } dummy(int) { } };
+
+    template<typename T>
+    using use_min_queue = std::disjunction<std::is_same<T, min_tag>, std::is_same<T, minmax_tag>>;
+    template<typename T>
+    using use_max_queue = std::disjunction<std::is_same<T, max_tag>, std::is_same<T, minmax_tag>>;
+    using stamp_deque_type = std::conditional_t<FixedSize, static_deque<Timestamp>, std::deque<Timestamp>>;
+public:
+    using duration_t = decltype(std::declval<Timestamp>() - std::declval<Timestamp>());
+
+    template<bool Enable = FixedSize, typename Require = std::enable_if_t<Enable>>
+    timed_minmax_queue(duration_t window, size_t n) : _window(window), _size(n), _values(n), _stamps(n) { }
+    template<bool Enable = !FixedSize, typename Require = std::enable_if_t<Enable>>
+    explicit timed_minmax_queue(duration_t window) : _window(window) { }
+
+    /**
+     * @brief advances the clock to ts and pushes val
+     */
+    void push(Timestamp const& ts, DataType const& val) {
+        advance_to(ts);
+        // eviction if fixed size, the value queue evicts on its own
+        if constexpr (FixedSize) {
+            if(!_size) {
+                return;
+            } else if(_stamps.size() == _size) {
+                _stamps.pop_front();
+            }
+        }
+        _values.push(val);
+        _stamps.push_back(ts);
+    }
+    /**
+     * @brief expires every value pushed at or before now - window
+     */
+    void advance_to(Timestamp const& now) {
+        size_t k = 0;
+        while(!_stamps.empty() && !(now - _stamps.front() < _window)) {
+            _stamps.pop_front();
+            ++k;
+        }
+        if(k)
+            _values.pop_n(k);
+    }
+    template<typename T = Tag, typename Require = std::enable_if_t<use_max_queue<T>::value>>
+    DataType const& max() const {
+        return _values.max();
+    }
+    template<typename T = Tag, typename Require = std::enable_if_t<use_min_queue<T>::value>>
+    DataType const& min() const {
+        return _values.min();
+    }
+    size_t size() const {
+        return _values.size();
+    }
+    bool empty() const {
+        return _stamps.empty();
+    }
+    duration_t window() const {
+        return _window;
+    }
+    Timestamp const& front_time() const {
+        return _stamps.front();
+    }
+    Timestamp const& back_time() const {
+        return _stamps.back();
+    }
+    DataType const& front() const {
+        return _values.front();
+    }
+    DataType const& back() const {
+        return _values.back();
+    }
+private:
+    duration_t _window;
+    std::conditional_t<FixedSize, size_t, dummy> _size;
+    minmax_queue<DataType, Tag, FixedSize> _values;
+    stamp_deque_type _stamps;
+};
\ No newline at end of file
@@ -3,22 +3,190 @@
 #include <type_traits>
 #include <algorithm>
 #include <functional>
+#include <cstdint>
+#include <ratio>
+#include <iterator>
+#include <cstddef>
 
 #define UNUSED(x) (void)(x)
 using node_id_t = int;
 struct null_t { };
 
+/** a comparator whose result is not bool is treated as three-way, i.e. it returns
+ *  something comparable against 0 (int, std::strong_ordering, ...) like a.compare(b) does
+ */
+template<typename CmpFn, typename A, typename B>
+using is_three_way_cmp = std::negation<std::is_same<std::invoke_result_t<CmpFn const&, A const&, B const&>, bool>>;
+
+template<typename A, typename B, typename = void>
+struct has_compare_fn : std::false_type { };
+template<typename A, typename B>
+struct has_compare_fn<A, B, std::void_t<decltype(std::declval<A const&>().compare(std::declval<B const&>()))>> : std::true_type { };
+
+template<typename CmpFn, typename = void>
+struct is_transparent_cmp : std::false_type { };
+template<typename CmpFn>
+struct is_transparent_cmp<CmpFn, std::void_t<typename CmpFn::is_transparent>> : std::true_type { };
+
+// transparent three-way comparator, uses a.compare(b) if available (e.g. std::string), otherwise operator<
+struct three_way_cmp {
+    using is_transparent = void;
+    template<typename A, typename B>
+    int operator()(A const& a, B const& b) const {
+        if constexpr (has_compare_fn<A, B>::value)
+            return a.compare(b);
+        else
+            return a < b ? -1 : (b < a);
+    }
+};
+
 template<typename Key, typename Mapped>
 struct null_treedata {
     void init(Key const& key, Mapped const& val) { UNUSED(key),UNUSED(val); }
     void combine(null_treedata const* lhs, null_treedata const* rhs) { UNUSED(lhs),UNUSED(rhs); }
 };
 
+/***
+ * instrumentation policies
+ */
+// default stats policy, every hook is empty and compiles away
+struct null_tree_stats {
+    void on_compare() { }
+    void on_rotate() { }
+    void on_pushup() { }
+    void on_splay(size_t path_len) { UNUSED(path_len); }
+    void on_color_flip() { }
+    void on_fixup() { }
+    void on_search(size_t depth) { UNUSED(depth); }
+};
+// counts tree operations
+struct tree_stats {
+    size_t comparisons = 0, rotations = 0, pushups = 0;
+    size_t splays = 0, splay_path = 0; // number of splays and total rotations done by them
+    size_t color_flips = 0, fixups = 0; // rbtree color flips, rebalancing steps of rbtree/avltree
+    size_t searches = 0;
+    std::vector<size_t> search_depth; // search_depth[d]: number of searches that visited d nodes
+
+    void on_compare() { ++ comparisons; }
+    void on_rotate() { ++ rotations; }
+    void on_pushup() { ++ pushups; }
+    void on_splay(size_t path_len) { ++ splays, splay_path += path_len; }
+    void on_color_flip() { ++ color_flips; }
+    void on_fixup() { ++ fixups; }
+    void on_search(size_t depth) {
+        ++ searches;
+        if(search_depth.size() <= depth) search_depth.resize(depth + 1);
+        ++ search_depth[depth];
+    }
+    void reset() { *this = tree_stats(); }
+    // reports every counter as f(name, value)
+    template<typename CounterFn>
+    void export_counters(CounterFn&& f) const {
+        f("comparisons", comparisons), f("rotations", rotations), f("pushups", pushups);
+        f("splays", splays), f("splay_path", splay_path);
+        f("color_flips", color_flips), f("fixups", fixups), f("searches", searches);
+    }
+    // reports the search depth histogram as f(depth, count), skipping empty buckets
+    template<typename BucketFn>
+    void export_search_depth(BucketFn&& f) const {
+        for(size_t d = 0; d < search_depth.size(); ++d)
+            if(search_depth[d]) f(d, search_depth[d]);
+    }
+};
+
+/***
+ * side indexes for point lookups
+ */
+// default index policy, every lookup goes through the tree
+template<typename Key>
+struct null_index {
+    static constexpr bool enabled = false;
+};
+/** open-addressing hash index from key to node id, linear probing with backward-shift deletion
+ *  a slot only stores the hash and the node id, keys are read from the tree's nodes through key_of
+ */
+template<typename Key, typename Hash = std::hash<Key>, typename KeyEq = std::equal_to<Key>>
+class hash_index {
+    struct slot {
+        uint32_t hash;
+        node_id_t id; // 0 (null_id) if the slot is empty
+    };
+    std::vector<slot> _slots; // size is 0 or a power of 2
+    size_t _count = 0;
+    Hash _hash;
+    KeyEq _eq;
+
+    size_t _mask() const { return _slots.size() - 1; }
+    size_t _locate(uint32_t h, node_id_t id) const {
+        size_t i = h & _mask();
+        while(_slots[i].id != id) i = (i + 1) & _mask();
+        return i;
+    }
+    void _place(slot s) {
+        size_t i = s.hash & _mask();
+        while(_slots[i].id != 0) i = (i + 1) & _mask();
+        _slots[i] = s;
+    }
+    void _grow() {
+        std::vector<slot> old(std::max<size_t>(16, _slots.size() * 2), slot{ 0, 0 });
+        old.swap(_slots);
+        for(slot const& s : old)
+            if(s.id != 0) _place(s);
+    }
+public:
+    static constexpr bool enabled = true;
+
+    uint32_t hash(Key const& key) const {
+        // std::hash is the identity for integers, spread it before masking
+        return static_cast<uint32_t>((static_cast<uint64_t>(_hash(key)) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+    template<typename KeyOfFn>
+    node_id_t find(Key const& key, KeyOfFn const& key_of) const {
+        if(_slots.empty()) return 0;
+        uint32_t h = hash(key);
+        for(size_t i = h & _mask(); _slots[i].id != 0; i = (i + 1) & _mask())
+            if(_slots[i].hash == h && _eq(key_of(_slots[i].id), key))
+                return _slots[i].id;
+        return 0;
+    }
+    // precondition: key is not indexed yet
+    void insert(Key const& key, node_id_t id) {
+        if(2 * (_count + 1) > _slots.size()) _grow();
+        _place(slot{ hash(key), id });
+        ++ _count;
+    }
+    // removes key if it is indexed to id
+    void erase(Key const& key, node_id_t id) {
+        if(_slots.empty()) return;
+        uint32_t h = hash(key);
+        size_t i = h & _mask();
+        for(; _slots[i].id != id; i = (i + 1) & _mask())
+            if(_slots[i].id == 0) return;
+        // shift back the following entries of the cluster that may not stay behind the hole
+        for(size_t j = (i + 1) & _mask(); _slots[j].id != 0; j = (j + 1) & _mask()) {
+            size_t home = _slots[j].hash & _mask();
+            if(((j - home) & _mask()) >= ((j - i) & _mask()))
+                _slots[i] = _slots[j], i = j;
+        }
+        _slots[i] = slot{ 0, 0 };
+        -- _count;
+    }
+    /** key a moved from node x to node y and key b from y to x; precondition: a is indexed to x, b to y
+     *  both slots are located before either is written, a and b may share a cluster
+     */
+    void swap_ids(Key const& a, node_id_t x, Key const& b, node_id_t y) {
+        size_t i = _locate(hash(a), x), j = _locate(hash(b), y);
+        std::swap(_slots[i].id, _slots[j].id);
+    }
+};
+
 template<typename Key,
          typename Mapped = null_t,
          typename CmpFn = std::less<Key>,
          typename BalanceData = null_treedata<Key, Mapped>,
-         typename MetaData = null_treedata<Key, Mapped>>
+         typename MetaData = null_treedata<Key, Mapped>,
+         typename Stats = null_tree_stats,
+         typename Index = null_index<Key>>
 class bst {
 public:
     using key_t = Key;
@@ -26,42 +194,100 @@ public:
     using cmp_fn = CmpFn;
     using balancedata_t = BalanceData;
     using metadata_t = MetaData;
+    using stats_t = Stats;
+    using index_t = Index;
+
+    // lookups accept any key type K if cmp_fn is transparent
+    template<typename K>
+    using require_transparent = std::enable_if_t<!std::is_same<K, key_t>::value && is_transparent_cmp<cmp_fn>::value>;
 
     static constexpr node_id_t null_id = 0;
-    struct node {
+    // true if the tree keeps no balance data, the node then has no balance_data member
+    static constexpr bool no_balance_data = std::is_same<balancedata_t, null_treedata<key_t, mapped_t>>::value;
+    template<typename T, bool Empty = no_balance_data>
+    struct balance_slot { T balance_data; }; // balance_data for various bst's
+    template<typename T>
+    struct balance_slot<T, true> { }; // empty base, takes no storage in node
+    struct node : balance_slot<balancedata_t> {
         node() : p(null_id) { sons[0] = sons[1] = null_id; }
-        node(key_t const& key, mapped_t const& data) {
-            init(key, data);
+        // constructs key from key and data from args in place
+        template<typename K, typename... Args>
+        node(std::piecewise_construct_t, K&& key, Args&&... args)
+            : p(null_id), key(std::forward<K>(key)), data(std::forward<Args>(args)...) {
+            sons[0] = sons[1] = null_id;
         }
-        void init(key_t const& key, mapped_t const& data) {
+        // reinitializes a recycled node, assigns instead of constructing
+        template<typename K, typename... Args>
+        void init(K&& key, Args&&... args) {
             p = sons[0] = sons[1] = null_id;
-            this->key = key;
-            this->data = data;
+            this->key = std::forward<K>(key);
+            if constexpr (sizeof...(Args) == 1 && std::conjunction<std::is_same<std::decay_t<Args>, mapped_t>...>::value)
+                this->data = (std::forward<Args>(args), ...);
+            else
+                this->data = mapped_t(std::forward<Args>(args)...);
         }
         int p, sons[2]; // parent, children
         key_t key;
         mapped_t data;
-        balancedata_t balance_data; // balance_data for various bst's
         metadata_t meta_data; // additional data to maintain
     };
+    // owns an entry taken out of a tree by extract(), can be inserted into a tree of the same type
+    struct node_handle {
+        key_t key;
+        mapped_t data;
+        bool valid = false;
+        explicit operator bool() const { return valid; }
+    };
+    // bidirectional in-order iterator over the nodes, end() is null_id
+    class const_iterator {
+        bst const* _tree = nullptr;
+        node_id_t _id = null_id;
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = node const*;
+        using reference = node const&;
+
+        const_iterator() = default;
+        const_iterator(bst const* tree, node_id_t id) : _tree(tree), _id(id) { }
+        node_id_t id() const { return _id; }
+        reference operator*() const { return _tree->get(_id); }
+        pointer operator->() const { return &_tree->get(_id); }
+        const_iterator& operator++() { _id = _tree->next(_id); return *this; }
+        const_iterator& operator--() {
+            _id = _id == null_id ? _tree->_extreme(_tree->root(), 1) : _tree->prev(_id);
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator ret = *this; ++ *this; return ret; }
+        const_iterator operator--(int) { const_iterator ret = *this; -- *this; return ret; }
+        bool operator==(const_iterator const& other) const { return _id == other._id; }
+        bool operator!=(const_iterator const& other) const { return _id != other._id; }
+    };
+    using iterator = const_iterator;
 protected:
     cmp_fn _cmp;
+    mutable stats_t _stats; // updated by const searches too
+    index_t _index;         // key -> node id for find(), kept in sync with the nodes' keys
     size_t _size;
     std::vector<node> _nodes;     // node pool, 1-indexed
     std::vector<int>  _free_list; // free list for the node pool
 
-    node_id_t _new_node(key_t const& key, mapped_t const& val) {
+    template<typename K, typename... Args>
+    node_id_t _new_node(K&& key, Args&&... args) {
         if(_free_list.empty()) {
-            _nodes.emplace_back(key, val);
+            _nodes.emplace_back(std::piecewise_construct, std::forward<K>(key), std::forward<Args>(args)...);
             return _nodes.size() - 1;
         } else {
             int ret = _free_list.back();
             _free_list.pop_back();
-            _nodes[ret].init(key, val);
+            _nodes[ret].init(std::forward<K>(key), std::forward<Args>(args)...);
             return ret;
         }
     }
     void _recycle(node_id_t id) {
+        // no-op for nodes that were never linked, their key is indexed to another node if at all
+        if constexpr (index_t::enabled) _index.erase(_nodes[id].key, id);
         _free_list.push_back(id);
     }
 #define N(x) _nodes[x]
@@ -77,6 +303,7 @@ protected:
         node_id_t p = N(x).p, g = N(p).p;
         bool d1 = N(g).sons[1] == p, d2 = N(p).sons[1] == x;
         node_id_t y = N(x).sons[!d2];
+        _stats.on_rotate();
         _relink(g, d1, x), _relink(p, d2, y), _relink(x, !d2, p);
         _pushup(p), _pushup(x);
     }
@@ -85,27 +312,129 @@ protected:
      *  postcondition: y.sons, x.sons, y.p, x.p are not swapped
      */
     void _swap_data(node_id_t x, node_id_t y) {
+        if constexpr (index_t::enabled)
+            _index.swap_ids(N(x).key, x, N(y).key, y);
         std::swap(N(x).key, N(y).key);
         std::swap(N(x).data, N(y).data);
-        if constexpr (!std::is_same<balancedata_t, null_treedata<key_t, mapped_t>>::value)
+        if constexpr (!no_balance_data)
             std::swap(N(x).balance_data, N(y).balance_data);
         if constexpr (!std::is_same<metadata_t, null_treedata<key_t, mapped_t>>::value)
             std::swap(N(x).meta_data, N(y).meta_data);
     }
+    /** three-way comparison, negative if a < b, 0 if equivalent, positive if a > b
+     *  calls the comparator once if it is three-way, otherwise at most twice
+     */
+    template<typename A, typename B>
+    int _compare(A const& a, B const& b) const {
+        _stats.on_compare();
+        if constexpr (is_three_way_cmp<cmp_fn, A, B>::value) {
+            auto c = _cmp(a, b);
+            return c < 0 ? -1 : (c > 0);
+        } else {
+            if(_cmp(a, b)) return -1;
+            _stats.on_compare();
+            return _cmp(b, a);
+        }
+    }
+    template<typename A, typename B>
+    bool _less(A const& a, B const& b) const {
+        _stats.on_compare();
+        if constexpr (is_three_way_cmp<cmp_fn, A, B>::value)
+            return _cmp(a, b) < 0;
+        else
+            return _cmp(a, b);
+    }
     /** does BST search and stops at the parent if it exists
      *  fills p with the parent node, dir with the target node's dir if it exists
      *  returns 1 if the node exists, else 0
      */
-    bool _find(key_t const& key, node_id_t& p, bool& dir) const {
+    template<typename K>
+    bool _find(K const& key, node_id_t& p, bool& dir) const {
         node_id_t u = root(); p = null_id; dir = 0;
+        size_t depth = 0;
         while (u != null_id) {
-            bool b1 = _cmp(key, N(u).key), b2 = _cmp(N(u).key, key);
-            if(b1 || b2)
-                p = u, u = N(u).sons[b2], dir = b2;
-            else return true;
+            int c = _compare(key, N(u).key);
+            ++ depth;
+            if(c)
+                p = u, dir = c > 0, u = N(u).sons[dir];
+            else return _stats.on_search(depth), true;
         }
+        _stats.on_search(depth);
         return false;
     }
+    /** first node whose key is not less than key (upper = 0) or greater than key (upper = 1)
+     *  fills last with the last visited node; one predicate call per level
+     */
+    template<typename K>
+    node_id_t _bound(K const& key, bool upper, node_id_t& last) const {
+        node_id_t u = root(), ret = null_id; last = null_id;
+        size_t depth = 0;
+        while (u != null_id) {
+            last = u, ++ depth;
+            bool right = upper ? !_less(key, N(u).key) : _less(N(u).key, key);
+            if(right) u = N(u).sons[1];
+            else ret = u, u = N(u).sons[0];
+        }
+        _stats.on_search(depth);
+        return ret;
+    }
+    template<typename K>
+    node_id_t _find_node(K const& key) {
+        // the index answers exact lookups without touching the tree shape
+        if constexpr (index_t::enabled && std::is_same<K, key_t>::value)
+            return _index.find(key, [this](node_id_t id) -> key_t const& { return N(id).key; });
+        node_id_t p; bool dir;
+        node_id_t x = _find(key, p, dir) ? N(p).sons[dir] : null_id;
+        _post_find(p,x);
+        return x;
+    }
+    template<typename K>
+    node_id_t _bound_node(K const& key, bool upper) {
+        node_id_t last, x = _bound(key, upper, last);
+        _post_find(last, x);
+        return x;
+    }
+    /** inserts key if it's not in the tree, make() is only called in that case
+     *  and must return an unlinked node holding key
+     */
+    template<typename MakeNodeFn>
+    node_id_t _insert(key_t const& key, MakeNodeFn&& make) {
+        node_id_t p; bool dir;
+        if(_insert_find(key, p, dir)) {
+            _post_insert(p, null_id);
+            return null_id;
+        }
+        node_id_t x = make();
+        if constexpr (index_t::enabled) _index.insert(N(x).key, x);
+        return _insert_at(p, dir, x);
+    }
+    /** removes key through erase_fn(key) and moves its entry into a node handle
+     *  erase_fn is the tree's own erase, so trees with their own erase pass (rbtree) descend once
+     */
+    template<typename K, typename EraseFn>
+    node_handle _extract(K const& key, EraseFn&& erase_fn) {
+        node_handle ret;
+        size_t sz = _size;
+        erase_fn(key);
+        if(_size != sz) {
+            // erase moves the entry into the node it unlinks, which is the last recycled one
+            node& x = N(_free_list.back());
+            ret.key = std::move(x.key), ret.data = std::move(x.data), ret.valid = true;
+        }
+        return ret;
+    }
+    template<typename K>
+    void _erase(K const& key) {
+        node_id_t p; bool dir;
+        if(_find(key, p, dir)) _erase_at(p, dir);
+        else _post_erase(p, null_id);
+    }
+    // leftmost (dir = 0) or rightmost (dir = 1) node of subtree x, null_id if x is null
+    node_id_t _extreme(node_id_t x, bool dir) const {
+        if(x == null_id) return null_id;
+        while(N(x).sons[dir] != null_id) x = N(x).sons[dir];
+        return x;
+    }
     /** find the successor or predecessor
      *  precondition: x must not be null
      */
@@ -125,17 +454,58 @@ protected:
             return null_id;
         }
     }
+    /** aggregates the keys of subtree u that are not beyond bound on side dir,
+     *  i.e. keys >= bound if dir is 0, keys <= bound if dir is 1
+     *  fills bottom with the last node of the walk and depth with its depth below u
+     *  returns 0 if there is no such key, otherwise fills ret
+     */
+    bool _query_side(node_id_t u, key_t const& bound, bool dir, metadata_t& ret,
+                     node_id_t& bottom, size_t& depth) const {
+        bottom = null_id, depth = 0;
+        if(u == null_id) return false;
+        // walk down to the boundary; a node is inside iff we leave it towards dir
+        node_id_t x = u; bool d;
+        while(true) {
+            bool inside = dir ? !_less(bound, N(x).key) : !_less(N(x).key, bound);
+            d = inside ? dir : !dir;
+            if(N(x).sons[d] == null_id) break;
+            x = N(x).sons[d], ++ depth;
+        }
+        bottom = x;
+        // fold back up, deeper inside nodes are further towards dir
+        bool found = false;
+        while(true) {
+            if(d == dir) {
+                node_id_t s = N(x).sons[!dir];
+                metadata_t const* sub[2];
+                sub[!dir] = s != null_id ? &N(s).meta_data : nullptr;
+                sub[dir] = found ? &ret : nullptr;
+                metadata_t cur;
+                cur.init(N(x).key, N(x).data);
+                cur.combine(sub[0], sub[1]);
+                ret = std::move(cur), found = true;
+            }
+            if(x == u) break;
+            d = N(N(x).p).sons[1] == x, x = N(x).p;
+        }
+        return found;
+    }
     // metadata info maintainance
     void _pushup(node_id_t x) {
+        _stats.on_pushup();
         node_id_t l = N(x).sons[0], r = N(x).sons[1];
         N(x).meta_data.init(N(x).key, N(x).data);
-        N(x).balance_data.init(N(x).key, N(x).data);
         metadata_t const* lmt = nullptr, * rmt = nullptr;
-        balancedata_t const* lbt = nullptr, * rbt = nullptr;
-        if(l != null_id) lmt = &N(l).meta_data, lbt = &N(l).balance_data;
-        if(r != null_id) rmt = &N(r).meta_data, rbt = &N(r).balance_data;
+        if(l != null_id) lmt = &N(l).meta_data;
+        if(r != null_id) rmt = &N(r).meta_data;
         N(x).meta_data.combine(lmt, rmt);
-        N(x).balance_data.combine(lbt, rbt);
+        if constexpr (!no_balance_data) {
+            N(x).balance_data.init(N(x).key, N(x).data);
+            balancedata_t const* lbt = nullptr, * rbt = nullptr;
+            if(l != null_id) lbt = &N(l).balance_data;
+            if(r != null_id) rbt = &N(r).balance_data;
+            N(x).balance_data.combine(lbt, rbt);
+        }
     }
     void _push_up_to_root(node_id_t x) {
         for(; x!=null_id; x=N(x).p)
@@ -151,71 +521,167 @@ protected:
     }
     // called after find x with parent p; x is null_id if it's not found
     virtual void _post_find(node_id_t p, node_id_t x) { UNUSED(p),UNUSED(x); }
+    /** search for insertion
+     *  returns 1 if key exists, otherwise fills p, dir with the slot the new node goes into
+     */
+    virtual bool _insert_find(key_t const& key, node_id_t& p, bool& dir) { return _find(key, p, dir); }
+    // links the new node x into p.sons[dir], returns the id of the new entry after rebalancing
+    virtual node_id_t _insert_at(node_id_t p, bool dir, node_id_t x) {
+        _relink(p, dir, x);
+        ++ _size;
+        _post_insert(p,x);
+        return x;
+    }
+    // removes the node p.sons[dir], which must exist
+    virtual void _erase_at(node_id_t p, bool dir) {
+        node_id_t x = N(p).sons[dir];
+        if(N(x).sons[0] != null_id && N(x).sons[1] != null_id) {
+            int u = _nxt(x, 1);
+            _swap_data(x, u);
+            x = u, p = N(x).p, dir = N(p).sons[1] == x;
+        }
+        _relink(p, dir, N(x).sons[N(x).sons[1] != null_id]);
+        _recycle(x);
+        -- _size;
+        _post_erase(p,x);
+    }
 public:
     template<typename T = cmp_fn, typename = std::enable_if_t<std::is_default_constructible<T>::value>>
     bst() : _size(0) { _nodes.emplace_back(); }
-    bst(cmp_fn cmp) : _size(0), _cmp(cmp) { _nodes.emplace_back(); }
+    bst(cmp_fn cmp) : _cmp(cmp), _size(0) { _nodes.emplace_back(); }
     node_id_t root() const { return _nodes[null_id].sons[0]; }
     node_id_t prev(node_id_t id) const { return _nxt(id,0); }
     node_id_t next(node_id_t id) const { return _nxt(id,1); }
     node const& get(node_id_t id) const { return _nodes[id]; }
+    stats_t& stats() { return _stats; }
+    stats_t const& stats() const { return _stats; }
     
+    /** aggregates meta_data over all keys in [lo, hi] in O(h)
+     *  the deepest visited node is accessed afterwards, so a splaytree splays it and the query
+     *  is amortized O(log n) there instead of O(h) on every call
+     *  returns false if no key falls in the range, otherwise fills ret
+     */
+    bool query(key_t const& lo, key_t const& hi, metadata_t& ret) {
+        // the topmost node in [lo, hi] splits the range into a suffix of its left subtree
+        // and a prefix of its right subtree
+        node_id_t u = root(), last = null_id;
+        while(u != null_id) {
+            last = u;
+            if(_less(N(u).key, lo)) u = N(u).sons[1];
+            else if(_less(hi, N(u).key)) u = N(u).sons[0];
+            else break;
+        }
+        if(u == null_id) {
+            _post_find(last, null_id);
+            return false;
+        }
+        metadata_t lhs, rhs;
+        node_id_t lb, rb; size_t ld, rd;
+        bool l = _query_side(N(u).sons[0], lo, 0, lhs, lb, ld);
+        bool r = _query_side(N(u).sons[1], hi, 1, rhs, rb, rd);
+        ret.init(N(u).key, N(u).data);
+        ret.combine(l ? &lhs : nullptr, r ? &rhs : nullptr);
+        // both side walks together are at most twice as long as the deeper one
+        node_id_t deepest = u;
+        if(lb != null_id && (rb == null_id || ld >= rd)) deepest = lb;
+        else if(rb != null_id) deepest = rb;
+        _post_find(N(deepest).p, deepest);
+        return true;
+    }
+    const_iterator begin() const { return const_iterator(this, _extreme(root(), 0)); }
+    const_iterator end() const { return const_iterator(this, null_id); }
+
+    // in-order traversal, iterative so degenerate trees can't overflow the stack
     template<typename CallbackFn>
-    void trav(CallbackFn&& f) {
-        auto impl = [&](auto& self, node_id_t cur) {
-            if(cur == null_id) return;
-            self(self, N(cur).sons[0]), f(get(cur)), self(self, N(cur).sons[1]);
-        };
-        impl(impl, root());
+    void trav(CallbackFn&& f) const {
+        for(node_id_t x = _extreme(root(), 0); x != null_id; x = _nxt(x, 1))
+            f(get(x));
+    }
+    /** in-order traversal of the keys in [lo, hi] in O(log n + k), amortized on splaytree
+     *  the start node is accessed like lower_bound(lo), so a splaytree splays it first
+     *  f may return bool, returning false stops the traversal
+     */
+    template<typename CallbackFn>
+    void trav_range(key_t const& lo, key_t const& hi, CallbackFn&& f) {
+        for(node_id_t x = _bound_node(lo, 0); x != null_id && !_less(hi, N(x).key); x = _nxt(x, 1)) {
+            if constexpr (std::is_same<std::invoke_result_t<CallbackFn&, node const&>, bool>::value) {
+                if(!f(get(x))) return;
+            } else {
+                f(get(x));
+            }
+        }
     }
     /** inserts a key value pair into bst
      *  on success, returns the id of the node
+     *  a template so that it is only instantiated when called, move-only mapped types then work
+     *  with emplace, try_emplace, extract and insert(node_handle)
      */
-    virtual node_id_t insert(key_t const& key, mapped_t const& value = null_t()) {
-        node_id_t p,x = null_id; bool dir;
-        if(!_find(key, p, dir)) {
-            x = _new_node(key, value);
-            _relink(p, dir, x);
-            ++ _size;
-        }
-        _post_insert(p,x);
-        return x;
+    template<typename M = mapped_t, typename = std::enable_if_t<std::is_same<M, mapped_t>::value>>
+    node_id_t insert(key_t const& key, mapped_t const& value = null_t()) {
+        return _insert(key, [&]() { return _new_node(key, value); });
     }
-    virtual void erase(key_t const& key) {
-        node_id_t p, x; bool dir;
-        if(_find(key, p, dir)) {
-            x = N(p).sons[dir];
-            if(N(x).sons[0] != null_id && N(x).sons[1] != null_id) {
-                int u = _nxt(x, 1);
-                _swap_data(x, u);
-                x = u, p = N(x).p, dir = N(p).sons[1] == x;
-            }
-            _relink(p, dir, N(x).sons[N(x).sons[1] != null_id]);
-            _recycle(x);
-            -- _size;
-        }
-        _post_erase(p,x);
+    /** constructs the entry in place from key and args, then inserts it
+     *  the entry is discarded if the key is already in the tree
+     */
+    template<typename K, typename... Args>
+    node_id_t emplace(K&& key, Args&&... args) {
+        node_id_t x = _new_node(std::forward<K>(key), std::forward<Args>(args)...);
+        node_id_t ret = _insert(N(x).key, [x]() { return x; });
+        if(ret == null_id) _recycle(x);
+        return ret;
     }
-    // key query functions
-    node_id_t find(key_t const& key) { 
-        node_id_t p; bool dir; 
-        node_id_t x = _find(key, p, dir) ? N(p).sons[dir] : null_id;
-        _post_find(p,x);
-        return x;
+    // like emplace, but does not touch key and args if the key is already in the tree
+    template<typename... Args>
+    node_id_t try_emplace(key_t const& key, Args&&... args) {
+        return _insert(key, [&]() { return _new_node(key, std::forward<Args>(args)...); });
     }
-    node_id_t lower_bound(key_t const& key) {
-        //todo
+    template<typename... Args>
+    node_id_t try_emplace(key_t&& key, Args&&... args) {
+        return _insert(key, [&]() { return _new_node(std::move(key), std::forward<Args>(args)...); });
     }
-    node_id_t upper_bound(key_t const& key) {
-        //todo
+    // inserts an extracted entry by moving it, nh is left untouched if the key is already in the tree
+    node_id_t insert(node_handle&& nh) {
+        if(!nh) return null_id;
+        node_id_t ret = _insert(nh.key, [&]() { return _new_node(std::move(nh.key), std::move(nh.data)); });
+        if(ret != null_id) nh.valid = false;
+        return ret;
     }
+    // removes key from the tree, its entry is moved out instead of destroyed
+    node_handle extract(key_t const& key) { return _extract(key, [this](key_t const& k) { erase(k); }); }
+    template<typename K, typename = require_transparent<K>>
+    node_handle extract(K const& key) { return _extract(key, [this](K const& k) { _erase(k); }); }
+    virtual void erase(key_t const& key) { _erase(key); }
+    template<typename K, typename = require_transparent<K>>
+    void erase(K const& key) { _erase(key); }
+    // key query functions
+    node_id_t find(key_t const& key) { return _find_node(key); }
+    template<typename K, typename = require_transparent<K>>
+    node_id_t find(K const& key) { return _find_node(key); }
+    // first node whose key is not less than key, null_id if there is none
+    node_id_t lower_bound(key_t const& key) { return _bound_node(key, 0); }
+    template<typename K, typename = require_transparent<K>>
+    node_id_t lower_bound(K const& key) { return _bound_node(key, 0); }
+    // first node whose key is greater than key, null_id if there is none
+    node_id_t upper_bound(key_t const& key) { return _bound_node(key, 1); }
+    template<typename K, typename = require_transparent<K>>
+    node_id_t upper_bound(K const& key) { return _bound_node(key, 1); }
     bool has(key_t const& key) { return find(key) != null_id; }
+    template<typename K, typename = require_transparent<K>>
+    bool has(K const& key) { return find(key) != null_id; }
     size_t size() const { return _size; }
 
     template<typename T = mapped_t, typename = std::enable_if_t<!std::is_same<T,null_t>::value>>
     mapped_t& operator[](key_t const& key) {
         node_id_t id = find(key);
-        if(id == null_id) return N(insert(key, mapped_t())).data;
+        if(id == null_id) return N(try_emplace(key)).data;
+        else return N(id).data;
+    }
+    // the key is only converted to key_t if it has to be inserted
+    template<typename K, typename = require_transparent<K>,
+             typename T = mapped_t, typename = std::enable_if_t<!std::is_same<T,null_t>::value>>
+    mapped_t& operator[](K const& key) {
+        node_id_t id = find(key);
+        if(id == null_id) return N(try_emplace(key_t(key))).data;
         else return N(id).data;
     }
 #undef N
@@ -237,20 +703,43 @@ struct size_metadata {
     }
 };
 
+// sums the mapped values of a subtree, also keeps the subtree size for at(k)
+template<typename Key, typename Mapped>
+struct sum_metadata : public size_metadata<Key, Mapped> {
+    Mapped sum;
+    void init(Key const& key, Mapped const& val) {
+        size_metadata<Key, Mapped>::init(key, val);
+        sum = val;
+    }
+    void combine(sum_metadata const* lhs, sum_metadata const* rhs) {
+        size_metadata<Key, Mapped>::combine(lhs, rhs);
+        if(lhs) sum = lhs->sum + sum;
+        if(rhs) sum = sum + rhs->sum;
+    }
+};
+
+template<typename T, typename = void>
+struct has_size_field : std::false_type { };
+template<typename T>
+struct has_size_field<T, std::void_t<decltype(std::declval<T const&>().size)>> : std::true_type { };
+
 template<typename Key,
          typename Mapped = null_t,
          typename CmpFn = std::less<Key>,
          typename BalanceData = null_treedata<Key, Mapped>,
-         typename MetaData = size_metadata<Key, Mapped>>
-struct update_policy : public bst<Key, Mapped, CmpFn, BalanceData, MetaData> {
-    using base = bst<Key, Mapped, CmpFn, BalanceData, MetaData>;
+         typename MetaData = size_metadata<Key, Mapped>,
+         typename Stats = null_tree_stats,
+         typename Index = null_index<Key>>
+struct update_policy : public bst<Key, Mapped, CmpFn, BalanceData, MetaData, Stats, Index> {
+    using base = bst<Key, Mapped, CmpFn, BalanceData, MetaData, Stats, Index>;
     using key_t = typename base::key_t;
     using mapped_t = typename base::mapped_t;
     using cmp_fn = typename base::cmp_fn;
     using metadata_t = typename base::metadata_t;
 #define N(x) base::_nodes[x]
-    template<typename T = metadata_t, typename = std::enable_if_t<std::is_same<T, size_metadata<key_t, mapped_t>>::value>>
-    node_id_t at(size_t k){
+    // k-th smallest key, 0-indexed; requires a metadata with a subtree size field
+    template<typename T = metadata_t, typename = std::enable_if_t<has_size_field<T>::value>>
+    node_id_t at(size_t k) const {
         node_id_t u = this->root();
         while (u != base::null_id) {
             size_t lsz = 0;
@@ -269,14 +758,62 @@ struct update_policy : public bst<Key, Mapped, CmpFn, BalanceData, MetaData> {
 /***
  * self-balancing BSTs
  */
+
+/***
+ * splay policies, decide whether and how an accessed node is splayed
+ * semi:                  semi-splay instead of splaying all the way to the root
+ * should_splay(n, depth) whether to restructure at all, depth() computes the depth of the node
+ */
+// splays every access to the root
+struct full_splay {
+    static constexpr bool semi = false;
+    template<typename DepthFn>
+    bool should_splay(size_t n, DepthFn&& depth) { UNUSED(n), UNUSED(depth); return true; }
+};
+// semi-splaying: a zig-zig step rotates only the parent, roughly halving the path with fewer rotations
+struct semi_splay {
+    static constexpr bool semi = true;
+    template<typename DepthFn>
+    bool should_splay(size_t n, DepthFn&& depth) { UNUSED(n), UNUSED(depth); return true; }
+};
+// splays only if the access path is longer than Num/Den * log2(n)
+template<unsigned Num = 2, unsigned Den = 1>
+struct depth_splay {
+    static constexpr bool semi = false;
+    template<typename DepthFn>
+    bool should_splay(size_t n, DepthFn&& depth) {
+        size_t lg = 0;
+        while((size_t(2) << lg) <= n) ++ lg;
+        return depth() * Den > Num * lg;
+    }
+};
+// splays an access with probability 1/Den
+template<unsigned Den = 4>
+struct random_splay {
+    static constexpr bool semi = false;
+    uint32_t state = 0x9E3779B9u; // xorshift32, must not be 0
+    template<typename DepthFn>
+    bool should_splay(size_t n, DepthFn&& depth) {
+        UNUSED(n), UNUSED(depth);
+        state ^= state << 13, state ^= state >> 17, state ^= state << 5;
+        return state % Den == 0;
+    }
+};
+
 template<typename Key, 
          typename Mapped = null_t,
-         typename CmpFn = std::less<Key>>
-class splaytree : public update_policy<Key, Mapped, CmpFn> {
-    using base = update_policy<Key, Mapped, CmpFn>;
+         typename CmpFn = std::less<Key>,
+         typename MetaData = size_metadata<Key, Mapped>,
+         typename Stats = null_tree_stats,
+         typename Index = null_index<Key>,
+         typename SplayPolicy = full_splay>
+class splaytree : public update_policy<Key, Mapped, CmpFn, null_treedata<Key, Mapped>, MetaData, Stats, Index> {
+    using base = update_policy<Key, Mapped, CmpFn, null_treedata<Key, Mapped>, MetaData, Stats, Index>;
 protected:
+    SplayPolicy _policy;
 #define N(x) base::_nodes[x]
     void _splay(node_id_t x, node_id_t k) {
+        size_t len = 0; // number of levels x climbs
         while (N(x).p != k) {
             node_id_t p = N(x).p, g = N(p).p;
             if (g != k) {
@@ -284,20 +821,56 @@ protected:
                     this->_rotate(x); // zig-zag
                 else
                     this->_rotate(p); // zig-zig
+                ++ len;
             }
             this->_rotate(x);
+            ++ len;
         }
+        this->_stats.on_splay(len);
+    }
+    // moves x up until it becomes the root; zig-zig steps rotate p only and continue from p
+    void _semi_splay(node_id_t x) {
+        size_t len = 0;
+        while (N(x).p != base::null_id) {
+            node_id_t p = N(x).p, g = N(p).p;
+            if (g == base::null_id) {
+                this->_rotate(x), ++ len; // zig
+            } else if ((N(p).sons[1] == x) ^ (N(g).sons[1] == p)) {
+                this->_rotate(x), this->_rotate(x), len += 2; // zig-zag
+            } else {
+                this->_rotate(p), ++ len; // zig-zig, p takes the place of g
+                x = p;
+            }
+        }
+        this->_stats.on_splay(len);
+    }
+    /** restructures after accessing x according to the splay policy
+     *  modified: the subtree of x changed, its metadata has to be recomputed up to the root
+     */
+    void _access(node_id_t x, bool modified) {
+        if(x == base::null_id) return;
+        auto depth = [this, x]() {
+            size_t d = 0;
+            for(node_id_t u = x; u != base::null_id; u = N(u).p) ++ d;
+            return d;
+        };
+        if(!_policy.should_splay(this->size(), depth)) {
+            if(modified) base::_push_up_to_root(x);
+            return;
+        }
+        // rotations recompute every ancestor of x, but not x itself
+        if(modified) base::_pushup(x);
+        if constexpr (SplayPolicy::semi) _semi_splay(x);
+        else _splay(x, base::null_id);
     }
     virtual void _post_insert(node_id_t p, node_id_t x) override {
-        if(x != base::null_id) _splay(x, base::null_id);
-        else if(p != base::null_id) _splay(p, base::null_id);
+        _access(x != base::null_id ? x : p, x != base::null_id);
     }
     virtual void _post_erase(node_id_t p, node_id_t x) override {
-        if(p != base::null_id) _splay(p, base::null_id), (void)x;
+        _access(p, x != base::null_id);
     }
     virtual void _post_find(node_id_t p, node_id_t x) override {
-        if(x != base::null_id) _splay(x, base::null_id);
-        else if(p != base::null_id) _splay(p, base::null_id);
+        _access(x != base::null_id ? x : p, false);
     }
 #undef N
 };
@@ -315,10 +888,13 @@ struct avl_data {
 };
 template<typename Key, 
          typename Mapped = null_t,
-         typename CmpFn = std::less<Key>>
-class avltree : public update_policy<Key, Mapped, CmpFn, avl_data<Key, Mapped>> {
+         typename CmpFn = std::less<Key>,
+         typename MetaData = size_metadata<Key, Mapped>,
+         typename Stats = null_tree_stats,
+         typename Index = null_index<Key>>
+class avltree : public update_policy<Key, Mapped, CmpFn, avl_data<Key, Mapped>, MetaData, Stats, Index> {
 protected:
-    using base = update_policy<Key, Mapped, CmpFn, avl_data<Key, Mapped>>;
+    using base = update_policy<Key, Mapped, CmpFn, avl_data<Key, Mapped>, MetaData, Stats, Index>;
 #define N(x) base::_nodes[x]
     int _get_height(node_id_t x) __attribute__((always_inline)) {
     // no need to check for null_id because N(null_id)'s height is 0
@@ -337,6 +913,7 @@ protected:
         base::_pushup(x), base::_pushup(p);
         while(g != base::null_id) {
             if(!_is_balanced(g)) {
+                this->_stats.on_fixup();
                 p = _tall_child(g), x = _tall_child(p);
                 if ((N(p).sons[1] == x) ^ (N(g).sons[1] == p)) 
                     this->_rotate(x), this->_rotate(x); // zig-zag
@@ -366,15 +943,22 @@ struct rb_data {
 };
 template<typename Key, 
          typename Mapped = null_t,
-         typename CmpFn = std::less<Key>>
-class rbtree : public update_policy<Key, Mapped, CmpFn, rb_data<Key, Mapped>> {
+         typename CmpFn = std::less<Key>,
+         typename MetaData = size_metadata<Key, Mapped>,
+         typename Stats = null_tree_stats,
+         typename Index = null_index<Key>>
+class rbtree : public update_policy<Key, Mapped, CmpFn, rb_data<Key, Mapped>, MetaData, Stats, Index> {
+public:
+    using key_t = Key;
+    using mapped_t = Mapped;
 protected:
-    using base = update_policy<Key, Mapped, CmpFn, rb_data<Key, Mapped>>;
+    using base = update_policy<Key, Mapped, CmpFn, rb_data<Key, Mapped>, MetaData, Stats, Index>;
     using color_t = typename rb_data<Key, Mapped>::color_t;
-    using key_t = typename base::key_t;
-    using mapped_t = typename base::mapped_t;
 #define N(x) base::_nodes[x]
-    void _flip_color(node_id_t x) { N(x).balance_data.color = (color_t)!(bool)N(x).balance_data.color; }
+    void _flip_color(node_id_t x) {
+        this->_stats.on_color_flip();
+        N(x).balance_data.color = (color_t)!(bool)N(x).balance_data.color;
+    }
     color_t _get_color(node_id_t x) __attribute__((always_inline)) {
     // no need to check for null_id because N(null_id)'s color is black
         return N(x).balance_data.color;
@@ -391,6 +975,7 @@ protected:
     }
     // make x,p,g a four-node
     int _fix_four_node(node_id_t x) {
+        this->_stats.on_fixup();
         int p = N(x).p, g = N(p).p;
         int r;
         if ((N(p).sons[1] == x) ^ (N(g).sons[1] == p)) {
@@ -403,45 +988,25 @@ protected:
         _set_color(r, color_t::B), _set_color(N(r).sons[0], color_t::R), _set_color(N(r).sons[1], color_t::R);
         return r;
     }
-public:
-    /* since I implement top-down insert/erase, rbtree needs to override insert and erase directly */
-    virtual node_id_t insert(key_t const& key, mapped_t const& value = null_t()) override {
-        node_id_t x = this->root(), p = base::null_id;
-        bool dir = false;
-        while(x != base::null_id) {
-            dir = this->_cmp(N(x).key, key);
-            if(this->_cmp(key, N(x).key) || dir) {
-                if(_is_four_node(x)) {
-                    _flip_color(N(x).sons[0]), _flip_color(N(x).sons[1]), _flip_color(x);
-                    if(_get_color(p) == color_t::R)
-                        _fix_four_node(x);
-                }
-            } else {
-                return base::null_id;
-            }
-            p = x, x = N(x).sons[dir];
-        }
-        x = base::_new_node(key, value), _set_color(x, color_t::R);
-        base::_relink(p, dir, x);
-        if(_get_color(p) == color_t::R)
-            _fix_four_node(x);
-        _set_color(this->root(), color_t::B);
-        ++ this->_size;
-        base::_post_insert(p,x);
-        return x;
-    }
-    virtual void erase(key_t const& key) override {
+    /** top-down erase
+     *  key may refer to the key of a node in the tree, keys are not moved until the descent ends
+     */
+    template<typename K>
+    void _rb_erase(K const& key) {
         node_id_t x, p = base::null_id, f = base::null_id, sibling = base::null_id;
         x = N(this->root()).p; // N(null_id).sons[0] is the root
         
         bool dir = false;
+        size_t depth = 0;
         while(N(x).sons[dir] != base::null_id) {
             p = x;
             sibling = N(x).sons[!dir];
             x = N(x).sons[dir];
+            ++ depth;
             
-            dir = this->_cmp(N(x).key, key);
-            if(!this->_cmp(key, N(x).key) && !dir)
+            int c = base::_compare(key, N(x).key);
+            dir = c > 0;
+            if(!c)
                 f = x;
 
             if(_is_two_node(x)) {
@@ -463,6 +1028,7 @@ public:
             }
         }
         _set_color(this->root(), color_t::B);
+        this->_stats.on_search(depth);
         
         if(f != base::null_id) {
             if(f != x) {
@@ -478,5 +1044,130 @@ public:
         }
         base::_post_erase(p,x);
     }
+    // top-down insertion pass, splits four-nodes on the way down
+    virtual bool _insert_find(key_t const& key, node_id_t& p, bool& dir) override {
+        node_id_t x = this->root();
+        p = base::null_id, dir = false;
+        size_t depth = 0;
+        while(x != base::null_id) {
+            int c = base::_compare(key, N(x).key);
+            ++ depth;
+            if(!c) {
+                // the descent may have split four-nodes up to the root
+                _set_color(this->root(), color_t::B);
+                p = N(x).p, dir = N(p).sons[1] == x;
+                this->_stats.on_search(depth);
+                return true;
+            }
+            dir = c > 0;
+            if(_is_four_node(x)) {
+                _flip_color(N(x).sons[0]), _flip_color(N(x).sons[1]), _flip_color(x);
+                if(_get_color(p) == color_t::R)
+                    _fix_four_node(x);
+            }
+            p = x, x = N(x).sons[dir];
+        }
+        this->_stats.on_search(depth);
+        return false;
+    }
+    virtual node_id_t _insert_at(node_id_t p, bool dir, node_id_t x) override {
+        _set_color(x, color_t::R);
+        base::_relink(p, dir, x);
+        if(_get_color(p) == color_t::R)
+            _fix_four_node(x);
+        _set_color(this->root(), color_t::B);
+        ++ this->_size;
+        base::_post_insert(p,x);
+        return x;
+    }
+    // the node is already known, but the top-down pass still has to walk down to it
+    virtual void _erase_at(node_id_t p, bool dir) override {
+        _rb_erase(N(N(p).sons[dir]).key);
+    }
+public:
+    using base::erase;
+    using base::extract;
+    /* since I implement top-down insert/erase, rbtree overrides the insertion hooks and erase directly */
+    virtual void erase(key_t const& key) override { _rb_erase(key); }
+    template<typename K, typename = typename base::template require_transparent<K>>
+    void erase(K const& key) { _rb_erase(key); }
+    template<typename K, typename = typename base::template require_transparent<K>>
+    typename base::node_handle extract(K const& key) { return base::_extract(key, [this](K const& k) { _rb_erase(k); }); }
+#undef N
+};
+/** scapegoat tree, balanced by subtree sizes alone so it needs no per-node balance data
+ *  after an insert or erase, the highest ancestor with a child heavier than Alpha of its size
+ *  is rebuilt into a perfectly balanced subtree by relinking its nodes, so entries never move
+ *  and node ids stay stable across inserts like in the other trees
+ *
+ *  memory: the node has no balance_data member at all, but MetaData's size_t size sets the node
+ *  alignment, and avltree/rbtree fit their 4-byte balance field into the padding that leaves;
+ *  with size_metadata the nodes of all three trees are the same size, e.g. 32 bytes for <int, int>
+ */
+template<typename Key, 
+         typename Mapped = null_t,
+         typename CmpFn = std::less<Key>,
+         typename MetaData = size_metadata<Key, Mapped>,
+         typename Stats = null_tree_stats,
+         typename Index = null_index<Key>,
+         typename Alpha = std::ratio<7, 10>>
+class sgtree : public update_policy<Key, Mapped, CmpFn, null_treedata<Key, Mapped>, MetaData, Stats, Index> {
+    static_assert(has_size_field<MetaData>::value, "sgtree balances on subtree sizes, MetaData needs a size field");
+    static_assert(Alpha::num * 2 > Alpha::den && Alpha::num < Alpha::den, "Alpha must be in (0.5, 1)");
+public:
+    using key_t = Key;
+    using mapped_t = Mapped;
+protected:
+    using base = update_policy<Key, Mapped, CmpFn, null_treedata<Key, Mapped>, MetaData, Stats, Index>;
+#define N(x) base::_nodes[x]
+    size_t _get_size(node_id_t x) const {
+        return x != base::null_id ? N(x).meta_data.size : 0;
+    }
+    bool _is_balanced(node_id_t x) const {
+        size_t limit = _get_size(x) * Alpha::num;
+        return _get_size(N(x).sons[0]) * Alpha::den <= limit && _get_size(N(x).sons[1]) * Alpha::den <= limit;
+    }
+    // links ids[0..n) as a perfectly balanced subtree, returns its root
+    node_id_t _build(node_id_t const* ids, size_t n) {
+        if(!n) return base::null_id;
+        size_t m = n / 2;
+        node_id_t x = ids[m];
+        base::_relink(x, 0, _build(ids, m));
+        base::_relink(x, 1, _build(ids + m + 1, n - m - 1));
+        base::_pushup(x);
+        return x;
+    }
+    // relinks the subtree of u into a perfectly balanced one, node ids and payloads stay put
+    void _rebuild(node_id_t u) {
+        this->_stats.on_fixup();
+        node_id_t p = N(u).p;
+        bool dir = N(p).sons[1] == u;
+        size_t n = _get_size(u);
+
+        // the scratch buffer is kept across rebuilds
+        _ids.resize(n);
+        _ids[0] = base::_extreme(u, 0);
+        for(size_t i = 1; i < n; ++i) _ids[i] = base::_nxt(_ids[i-1], 1);
+        base::_relink(p, dir, _build(_ids.data(), n));
+    }
+    // rebuilds the highest unbalanced ancestor of x, sizes from x up must be up to date
+    void _rebalance(node_id_t x) {
+        node_id_t goat = base::null_id;
+        for(; x != base::null_id; x = N(x).p)
+            if(!_is_balanced(x)) goat = x;
+        if(goat != base::null_id) _rebuild(goat);
+    }
+    virtual node_id_t _insert_at(node_id_t p, bool dir, node_id_t x) override {
+        base::_relink(p, dir, x);
+        ++ this->_size;
+        base::_push_up_to_root(x);
+        _rebalance(x);
+        return x;
+    }
+    virtual void _post_erase(node_id_t p, node_id_t x) override {
+        if(x != base::null_id) base::_push_up_to_root(p), _rebalance(p);
+    }
+
+    std::vector<node_id_t> _ids; // in-order ids of the subtree being rebuilt
 #undef N
-};
\ No newline at end of file
+};
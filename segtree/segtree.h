@@ -5,6 +5,24 @@
 using std::vector;
 
 struct no_lazy_prop_tag { };
+
+// default stats policy, every hook is empty and compiles away
+struct null_segtree_stats {
+    void on_visit() { }
+    void on_push() { }
+};
+// counts node visits of updates/queries and lazy tag pushes
+struct segtree_stats {
+    size_t visits = 0, pushes = 0;
+    void on_visit() { ++ visits; }
+    void on_push() { ++ pushes; }
+    void reset() { *this = segtree_stats(); }
+    // reports every counter as f(name, value)
+    template<typename CounterFn>
+    void export_counters(CounterFn&& f) const {
+        f("visits", visits), f("pushes", pushes);
+    }
+};
 /**
  * @brief a segment tree
  * 
@@ -12,12 +30,14 @@ struct no_lazy_prop_tag { };
  * @tparam CombineFn: a binary function that takes two DataType and returns a combined DataType  
  * @tparam ResolveFn: (only in lazy propagation) a function that is equivalent to applying CombineFn over a range of DataType in [l,r]
  * @tparam CumulativeUpdate: whether update overwrites or adds to the data
+ * @tparam Stats: instrumentation policy, null_segtree_stats or segtree_stats
  */
 template<
     typename DataType,
     typename CombineFn,
     typename ResolveFn = no_lazy_prop_tag,
-    bool     CumulativeUpdate = false
+    bool     CumulativeUpdate = false,
+    typename Stats = null_segtree_stats
 >
 class segtree {
     struct base_node {
@@ -97,28 +117,32 @@ public:
     }
 
     DataType queryall() {
-        DataType ret;
+        DataType ret{};
         _query(ret, 0, _max_index, 0, 0, _max_index);
         return ret;
     }
 
     DataType query(int l, int r) {
-        DataType ret;
+        DataType ret{};
         _query(ret, l, r, 0, 0, _max_index);
         return ret;
     }
 
     DataType operator[](int index) {
-        DataType ret;
+        DataType ret{};
         _query(ret, index, index, 0, 0, _max_index);
         return ret;
     }
 
+    Stats& stats() { return _stats; }
+    Stats const& stats() const { return _stats; }
+
 private:
     vector<node_type> _nodes;
     int _max_index;
     CombineFn _combineFn;
     ResolveFn _resolvefn;
+    Stats _stats;
 
     int _new_node() {
         _nodes.emplace_back(-1,-1);
@@ -175,6 +199,7 @@ private:
 
     template<typename = typename std::enable_if<no_lazy_prop::value>>
     void _update(int idx, DataType const& val, int i, int l, int r) {
+        _stats.on_visit();
         if (l >= r) {
             if constexpr (CumulativeUpdate)
                 N(i).val += val;
@@ -195,6 +220,7 @@ private:
 
     template<typename = typename std::enable_if<!no_lazy_prop::value>>
     void _update(int ql, int qr, DataType const& val, int i, int l, int r) {
+        _stats.on_visit();
         _resolve_update(i,l,r);
 
         if(ql > r || qr < l)
@@ -212,6 +238,7 @@ private:
     }
 
     bool _query(DataType& ret, int ql, int qr, int i, int l, int r) {
+        _stats.on_visit();
         if constexpr (!no_lazy_prop::value)
             _resolve_update(i,l,r);
 
@@ -242,6 +269,7 @@ private:
     {
         if(N(i).lazy)
         {
+            _stats.on_push();
             _apply(i,l,r,N(i).pending);
             N(i).lazy = 0;
             N(i).pending = 0;
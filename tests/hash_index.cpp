@@ -0,0 +1,72 @@
+/**
+ * @brief randomized check of hash_index against std::set on every tree of the bst family
+ *
+ * build: g++ -O2 -std=c++17 tests/hash_index.cpp -o hash_index_test
+ *
+ * a colliding hash puts all keys into a few clusters, so the two slots touched by
+ * _swap_data during a two-child erase often share one. every key is checked with has()
+ * after every erase.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+
+#include "../ordered_containers/bst.h"
+
+struct colliding_hash {
+    size_t operator()(int k) const { return static_cast<size_t>(k % 3); }
+};
+
+template<typename Tree>
+bool check(Tree& t, std::set<int> const& ref, int domain, char const* name, unsigned seed) {
+    if(t.size() != ref.size()) {
+        std::printf("%s seed %u: size %zu, expected %zu\n", name, seed, t.size(), ref.size());
+        return false;
+    }
+    for(int k = 0; k < domain; ++k) {
+        if(t.has(k) != (ref.count(k) > 0)) {
+            std::printf("%s seed %u: has(%d) mismatch\n", name, seed, k);
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Tree>
+int run(char const* name, unsigned seeds) {
+    constexpr int domain = 128;
+    int failed = 0;
+    for(unsigned seed = 0; seed < seeds; ++seed) {
+        Tree t;
+        std::set<int> ref;
+        std::mt19937 rng(seed);
+        bool ok = true;
+        for(int i = 0; i < 2000 && ok; ++i) {
+            int k = static_cast<int>(rng() % domain);
+            if(rng() % 3) {
+                t.insert(k, i), ref.insert(k);
+            } else {
+                t.erase(k), ref.erase(k);
+                ok = check(t, ref, domain, name, seed);
+            }
+        }
+        failed += !ok;
+    }
+    std::printf("%-18s %u/%u seeds ok\n", name, seeds - failed, seeds);
+    return failed;
+}
+
+template<typename Hash>
+using index_t = hash_index<int, Hash>;
+
+int main() {
+    constexpr unsigned seeds = 200;
+    int failed = 0;
+    failed += run<splaytree<int, int, std::less<int>, size_metadata<int, int>, null_tree_stats, index_t<colliding_hash>>>("splaytree", seeds);
+    failed += run<avltree<int, int, std::less<int>, size_metadata<int, int>, null_tree_stats, index_t<colliding_hash>>>("avltree", seeds);
+    failed += run<rbtree<int, int, std::less<int>, size_metadata<int, int>, null_tree_stats, index_t<colliding_hash>>>("rbtree", seeds);
+    failed += run<sgtree<int, int, std::less<int>, size_metadata<int, int>, null_tree_stats, index_t<colliding_hash>>>("sgtree", seeds);
+    failed += run<avltree<int, int, std::less<int>, size_metadata<int, int>, null_tree_stats, index_t<std::hash<int>>>>("avltree/std::hash", seeds);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}